@@ -0,0 +1,93 @@
+/******************************************************************************
+ * charset_latin1
+ * 
+ * Extended character set for gfxfont_5x7 text, see textgfx_set_charset().
+ * The Latin-1 letters and signs found on instrument panels (accents, degree,
+ * micro, plus-minus, fractions), some Greek for units and the euro sign,
+ * arrows and comparison signs.
+ * 
+ * Glyphs are the 5x7 font's own, 5 columns of 7 bits each, bit packed back to
+ * back (LSB first) so only the included glyphs take flash, 35 bits each.
+ * One pad octet at the end. Code points map to glyphs through the sorted 
+ * range table.
+ */
+
+#include <textgfx.h>
+
+static const uint8_t charset_latin1_data[] = {
+	0x00, 0xC0, 0x1E, 0x00, 0xE0, 0x91, 0xFE, 0x24, 0x12, 0xD2, 0x9F, 0x1C,
+	0x9A, 0x57, 0x2F, 0xFE, 0x6B, 0x65, 0x4A, 0xA5, 0x5E, 0x28, 0x04, 0x45,
+	0x45, 0x11, 0x21, 0x10, 0x08, 0x04, 0xCE, 0xF0, 0x48, 0x3C, 0x0C, 0x44,
+	0xE2, 0x97, 0x48, 0x04, 0x64, 0x3A, 0x17, 0x09, 0xD0, 0x0F, 0xF2, 0x80,
+	0x00, 0x00, 0x08, 0x04, 0x60, 0x4A, 0xA5, 0x52, 0x26, 0x11, 0x45, 0x45,
+	0x41, 0xBC, 0x20, 0x28, 0x9A, 0xFE, 0x05, 0x41, 0xB2, 0x74, 0x30, 0x64,
+	0x13, 0x08, 0x82, 0xA7, 0x48, 0x29, 0x38, 0x1C, 0x55, 0x42, 0xC1, 0xF9,
+	0x8A, 0xC4, 0x3F, 0xE9, 0x09, 0x85, 0xC2, 0x12, 0x3E, 0xB5, 0x5A, 0x04,
+	0xF4, 0x1B, 0x99, 0x58, 0x3F, 0x47, 0x24, 0x12, 0x73, 0x3D, 0x20, 0x10,
+	0xD8, 0xE3, 0xAB, 0x54, 0x3E, 0x4A, 0xA8, 0x4A, 0xC5, 0x03, 0x41, 0x54,
+	0x6A, 0x3E, 0x18, 0xAA, 0x56, 0xF3, 0xC1, 0x10, 0x95, 0x8A, 0x0F, 0x82,
+	0xA8, 0xD5, 0x3C, 0x10, 0x44, 0xA5, 0xF2, 0xA9, 0x0C, 0x8F, 0x54, 0x2E,
+	0xC9, 0x55, 0xA9, 0x54, 0x2C, 0x8E, 0x4A, 0xAD, 0x66, 0x73, 0xD5, 0x6A,
+	0x35, 0x9B, 0xA3, 0x52, 0xA9, 0x59, 0x40, 0xA0, 0xC8, 0x07, 0x02, 0x00,
+	0xC4, 0x7E, 0x10, 0x20, 0x28, 0xF6, 0x85, 0x00, 0x40, 0x91, 0x1F, 0x04,
+	0xE8, 0x15, 0x0A, 0xB9, 0x4C, 0x89, 0x44, 0xC2, 0x60, 0x48, 0xA4, 0x52,
+	0x26, 0x4B, 0x26, 0x93, 0x32, 0x19, 0x12, 0x89, 0x94, 0x21, 0x10, 0xEB,
+	0x35, 0x42, 0x27, 0x04, 0x82, 0xF0, 0x38, 0x20, 0x50, 0xA4, 0xD7, 0x05,
+	0x83, 0x21, 0xBD, 0x0E, 0x08, 0x04, 0xE9, 0x01, 0x1D, 0x10, 0xA8, 0xEF,
+	0x17, 0x08, 0x0C, 0x06, 0x8E, 0x2A, 0xA9, 0xE2, 0x8C, 0xAB, 0xC9, 0xE0,
+	0x38, 0x53, 0x3A, 0x97, 0x32, 0x4C, 0x79, 0x40, 0xCE, 0xC4, 0x11, 0x89,
+	0x38, 0x22, 0x4C, 0xD9, 0x6C, 0xC2, 0x7C, 0xC9, 0x64, 0x12, 0x20, 0xF0,
+	0x0B, 0xFC, 0x02, 0x1C, 0x91, 0xC8, 0x23, 0x18, 0x04, 0x7E, 0x81, 0x80,
+	0x27, 0xD6, 0x1A, 0x7B, 0x14, 0x5F, 0xB5, 0x1A, 0x44, 0x70, 0x54, 0x08,
+	0x04, 0x82, 0xE0, 0x27, 0x20, 0x10, 0x08, 0x15, 0x07, 0x01, 0x01, 0xF9,
+	0x41, 0x10, 0x18, 0xF0, 0x1F, 0x08, 0xC0, 0x90, 0x78, 0x24, 0xCC, 0x26,
+	0xB1, 0x91, 0x6C, 0x2A, 0x95, 0x4A, 0xA5, 0x02, 0x12, 0x95, 0x51, 0x20,
+	0x30, 0xAA, 0x24, 0x02, 0x01, 0x3C, 0x1E, 0x8F, 0x07, 0x00,
+};
+
+static const gfxcharset_range_t charset_latin1_ranges[] = {
+	{0x00A1,  3,  0}, // ¡¢£
+	{0x00A5,  1,  3}, // ¥
+	{0x00AA,  3,  4}, // ª«¬
+	{0x00B0,  3,  7}, // °±²
+	{0x00B5,  1, 10}, // µ
+	{0x00B7,  1, 11}, // ·
+	{0x00BA,  4, 12}, // º»¼½
+	{0x00BF,  1, 16}, // ¿
+	{0x00C4,  4, 17}, // ÄÅÆÇ
+	{0x00C9,  1, 21}, // É
+	{0x00D1,  1, 22}, // Ñ
+	{0x00D6,  1, 23}, // Ö
+	{0x00DC,  1, 24}, // Ü
+	{0x00DF,  4, 25}, // ßàáâ
+	{0x00E4, 12, 29}, // äåæçèéêëìíîï
+	{0x00F1,  4, 41}, // ñòóô
+	{0x00F6,  2, 45}, // ö÷
+	{0x00F9,  4, 47}, // ùúûü
+	{0x00FF,  1, 51}, // ÿ
+	{0x0393,  1, 52}, // Γ
+	{0x0398,  1, 53}, // Θ
+	{0x03A3,  1, 54}, // Σ
+	{0x03A6,  1, 55}, // Φ
+	{0x03A9,  1, 56}, // Ω
+	{0x03B1,  1, 57}, // α
+	{0x03B4,  2, 58}, // δε
+	{0x03C0,  1, 60}, // π
+	{0x03C3,  2, 61}, // στ
+	{0x03C6,  1, 63}, // φ
+	{0x20AC,  1, 64}, // €
+	{0x2190,  4, 65}, // ←↑→↓
+	{0x221A,  1, 69}, // √
+	{0x221E,  1, 70}, // ∞
+	{0x2248,  1, 71}, // ≈
+	{0x2261,  1, 72}, // ≡
+	{0x2264,  2, 73}, // ≤≥
+	{0x25A0,  1, 75}, // ■
+};
+
+const gfxcharset_t gfxcharset_latin1 = {
+    .data        = charset_latin1_data,
+    .ranges      = charset_latin1_ranges,
+    .range_count = sizeof(charset_latin1_ranges) / sizeof(charset_latin1_ranges[0]),
+    .glyph_count = 76,
+};
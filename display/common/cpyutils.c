@@ -7,6 +7,10 @@
  * 
  * Features:
  *  - mis-aligned copy operation : copy one fb to another at any (x,y) pixel coord.
+ *  - rectangle copies clipped on all edges of source and destination.
+ *  - RLE compressed bitmaps, decoded straight into the framebuffer.
+ *  - row-major (XBM/PBM) to page format conversion and back.
+ *  - rectangle fill/clear/invert.
  * 
  * Limitations:
  */
@@ -15,6 +19,12 @@
 #include <stdlib.h>
 #include <cpyutils.h>
 
+#define FRAMEBUF_LINES_PER_PG 8
+
+// rect_xfer() write modes
+#define XFER_COPY   0   /* replace destination pixels inside the rect */
+#define XFER_OR     1   /* OR source pixels into the destination      */
+
 // simple buffer clear
 int gfxutil_fb_clear(uint8_t * fb, size_t len, uint8_t fast_clean) {
     int rc = -1;
@@ -64,14 +74,146 @@ int gfxutil_fb_merge(uint8_t * from, uint8_t * mask, uint8_t * to, size_t len) {
     return rc;
 }
 
+// floor(v / 8) for signed pixel rows
+static inline int row_to_page(int v) {
+    return (v >= 0) ? (v >> 3) : -((7 - v) >> 3);
+}
+
+/******************************************************************************
+ * Rectangle transfer kernel, all other copies are built on top of this.
+ * 
+ * Moves the (w x h) pixel rect at (sx,sy) of 'src' to (dx,dy) of 'dst'. Both
+ * buffers are page format (8 rows per octet, LSB on top). The rect is clipped
+ * against all edges of both buffers, coords may be negative.
+ * 
+ * Per destination page a row mask of the rows inside the rect is built and
+ * the source bits are lined up with it: straight from one source page when
+ * the vertical offset is page aligned, otherwise shifted from the two source
+ * pages straddling it. Aligned full pages in XFER_COPY mode are a memcpy().
+ * 
+ * Returns # octets written into 'dst', 0 if clipped away.
+ */
+static int rect_xfer(const uint8_t * src, int src_w, int src_pages, int sx, int sy,
+                     int w, int h, uint8_t * dst, int dst_w, int dst_pages, int dx, int dy, 
+                     int mode) {
+    int dp, dp_end;
+    int count = 0;
+    // clip to the source
+    if (sx < 0) { dx -= sx; w += sx; sx = 0; }
+    if (sy < 0) { dy -= sy; h += sy; sy = 0; }
+    if (sx + w > src_w) w = src_w - sx;
+    if (sy + h > src_pages * FRAMEBUF_LINES_PER_PG) h = (src_pages * FRAMEBUF_LINES_PER_PG) - sy;
+    // clip to the destination
+    if (dx < 0) { sx -= dx; w += dx; dx = 0; }
+    if (dy < 0) { sy -= dy; h += dy; dy = 0; }
+    if (dx + w > dst_w) w = dst_w - dx;
+    if (dy + h > dst_pages * FRAMEBUF_LINES_PER_PG) h = (dst_pages * FRAMEBUF_LINES_PER_PG) - dy;
+    if (w <= 0 || h <= 0)
+        return 0;
+
+    dp_end = (dy + h - 1) >> 3;
+    for (dp = (dy >> 3) ; dp <= dp_end ; dp++) {
+        int     top  = dy - (dp * FRAMEBUF_LINES_PER_PG);          // first row of the rect in this page
+        int     bot  = (dy + h) - (dp * FRAMEBUF_LINES_PER_PG);    // one past the last row
+        int     sr, sp, sh, i;
+        uint8_t m, keep;
+        const uint8_t * lo;
+        const uint8_t * hi;
+        uint8_t * d = dst + (dp * dst_w) + dx;
+
+        if (top < 0) top = 0;
+        if (bot > 8) bot = 8;
+        m    = (uint8_t)((0xff << top) & (0xff >> (8 - bot)));
+        keep = (mode == XFER_COPY) ? (uint8_t)~m : 0xff;
+
+        // source row lining up with bit 0 of this dest page, split into page + shift.
+        // Rows from pages outside the source are always outside the mask.
+        sr = sy + (dp * FRAMEBUF_LINES_PER_PG) - dy;
+        sp = row_to_page(sr);
+        sh = sr - (sp * FRAMEBUF_LINES_PER_PG);
+        lo = (sp >= 0 && sp < src_pages) ? src + (sp * src_w) + sx : NULL;
+        hi = (sh && (sp + 1) < src_pages) ? src + ((sp + 1) * src_w) + sx : NULL;
+
+        if (sh == 0) {
+            if (m == 0xff && mode == XFER_COPY) {
+                memcpy(d, lo, w);
+            } else {
+                for (i = 0 ; i < w ; i++)
+                    d[i] = (d[i] & keep) | (lo[i] & m);
+            }
+        } else if (lo && hi) {
+            for (i = 0 ; i < w ; i++)
+                d[i] = (d[i] & keep) | (((lo[i] >> sh) | (hi[i] << (8 - sh))) & m);
+        } else if (lo) {
+            for (i = 0 ; i < w ; i++)
+                d[i] = (d[i] & keep) | ((lo[i] >> sh) & m);
+        } else {
+            for (i = 0 ; i < w ; i++)
+                d[i] = (d[i] & keep) | ((uint8_t)(hi[i] << (8 - sh)) & m);
+        }
+        count += w;
+    }
+    return count;
+}
+
 // framebuffer --> framebuffer copy
 int gfxutil_fbfb_copy(fbdata_t * from, fbdata_t * to) {
-    return -1;
+    int rc = -1;
+    if (from && to && from->ftb && to->ftb) {
+        rc = 0;
+        if (from->rows_per_page == FRAMEBUF_LINES_PER_PG && to->rows_per_page == FRAMEBUF_LINES_PER_PG
+            && from->fb_width && to->fb_width) {
+            int src_pages = (from->fb_height + FRAMEBUF_LINES_PER_PG - 1) / FRAMEBUF_LINES_PER_PG;
+            int dst_pages = (to->fb_height + FRAMEBUF_LINES_PER_PG - 1) / FRAMEBUF_LINES_PER_PG;
+            int w = (from->cpy_width)  ? from->cpy_width  : from->fb_width  - from->tl_posn_x;
+            int h = (from->cpy_height) ? from->cpy_height : from->fb_height - from->tl_posn_y;
+            if (from->cpylen && (int)(from->cpylen / from->fb_width) < src_pages)
+                src_pages = from->cpylen / from->fb_width;
+            // pixel heights need not be page multiples
+            if (from->tl_posn_y + h > from->fb_height)
+                h = from->fb_height - from->tl_posn_y;
+            if (to->tl_posn_y + h > to->fb_height)
+                h = to->fb_height - to->tl_posn_y;
+            rc = rect_xfer((const uint8_t *)from->ftb, from->fb_width, src_pages, 
+                           from->tl_posn_x, from->tl_posn_y, w, h,
+                           (uint8_t *)to->ftb, to->fb_width, dst_pages,
+                           to->tl_posn_x, to->tl_posn_y, XFER_COPY);
+        }
+    }
+    return rc;
 }
 
 // textbuffer --> framebuffer copy
 int gfxutil_tbfb_copy(fbdata_t * from, fbdata_t * to) {
-    return -1;
+    int rc = -1;
+    if (from && to && from->ftb && from->font && to->ftb) {
+        rc = 0;
+        if (to->rows_per_page == FRAMEBUF_LINES_PER_PG && to->fb_width) {
+            int dst_pages = (to->fb_height + FRAMEBUF_LINES_PER_PG - 1) / FRAMEBUF_LINES_PER_PG;
+            int cols = (from->cpy_width)  ? from->cpy_width  : from->fb_width  - from->tl_posn_x;
+            int rows = (from->cpy_height) ? from->cpy_height : from->fb_height - from->tl_posn_y;
+            int c, r, i;
+            uint8_t cell[GFXUTIL_TXT_CELL_W];
+            if (from->tl_posn_x + cols > from->fb_width)
+                cols = from->fb_width - from->tl_posn_x;
+            if (from->tl_posn_y + rows > from->fb_height)
+                rows = from->fb_height - from->tl_posn_y;
+            cell[GFXUTIL_TXT_CELL_W - 1] = 0; // spacing column
+            for (r = 0 ; r < rows ; r++) {
+                const char * t = from->ftb + ((from->tl_posn_y + r) * from->fb_width) + from->tl_posn_x;
+                int y = to->tl_posn_y + (r * GFXUTIL_TXT_CELL_H);
+                for (c = 0 ; c < cols ; c++) {
+                    const uint8_t * g = from->font + ((uint8_t)t[c] * GFXUTIL_TXT_GLYPH_W);
+                    for (i = 0 ; i < GFXUTIL_TXT_GLYPH_W ; i++)
+                        cell[i] = g[i] & 0x7f; // bottom row kept blank between text lines
+                    rc += rect_xfer(cell, GFXUTIL_TXT_CELL_W, 1, 0, 0, GFXUTIL_TXT_CELL_W, GFXUTIL_TXT_CELL_H,
+                                    (uint8_t *)to->ftb, to->fb_width, dst_pages,
+                                    to->tl_posn_x + (c * GFXUTIL_TXT_CELL_W), y, XFER_COPY);
+                }
+            }
+        }
+    }
+    return rc;
 }
 
 /******************************************************************************
@@ -101,50 +243,407 @@ int gfxutil_tbfb_copy(fbdata_t * from, fbdata_t * to) {
  *      1 := failure, check params.
  * 
  */
-#define FRAMEBUF_LINES_PER_PG 8
-int gfxutil_blit(const uint8_t * from, size_t from_width, size_t from_pages, bool overwrite, size_t at_x, size_t at_y, uint8_t * to, size_t to_width, size_t to_pages) {
+int gfxutil_blit(const uint8_t * from, size_t from_width, size_t from_pages, bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, size_t to_pages) {
     int rc = 1;
     if (from && to) {
-        uint8_t  to_pg    = at_y / FRAMEBUF_LINES_PER_PG;  // dest page (Y) index -> to[]
-        uint8_t  n        = at_y % FRAMEBUF_LINES_PER_PG;  // line-misalignment in no. of bits. 0 := aligned
-        uint8_t  fbmask   = 0xff >> (8 - n);               // for retaining existing framebuffer data (shifted digit location)
-        uint8_t  fbmasknxt= 0xff << n;                     // mask for the next page down, if shifted.
-        size_t   f_idx    = 0;                             // index for the source 'from' buffer
-        size_t   f_len    = (from_width * from_pages);     // total length of the source buffer
-        size_t   fb_start = (to_pg * to_width) + at_x;     // starting index into FB (by page)
-        size_t   t_len    = (to_width * to_pages);         // byte/octet length of the dest buffer (linear array geometry)
-        size_t   digwidth = 0;      // a tracking counter that catches rollover to the next page in the source bitmap
-
-        while (f_idx < f_len) {
-            // prevent overflow off the right of the page, ignore any blit going there ... er... how?
-            
-            if (overwrite)
-                to[fb_start] &= fbmask;
-            to[fb_start] |= (from[f_idx] << n);
-
-            if (n && (fb_start + to_width) < t_len) {
-                // render remaining part of the display digit into the next page below,
-                // as long as it is still within the framebuffer
-                if (overwrite)
-                    to[fb_start+to_width] &= fbmasknxt;
-                to[fb_start+to_width] |= (from[f_idx] >> (8-n));
+        // clipping to the visible window is done up front by the kernel, 
+        // each page is then one run of whole clipped rows.
+        rect_xfer(from, (int)from_width, (int)from_pages, 0, 0, 
+                  (int)from_width, (int)(from_pages * FRAMEBUF_LINES_PER_PG),
+                  to, (int)to_width, (int)to_pages, at_x, at_y, 
+                  (overwrite) ? XFER_COPY : XFER_OR);
+        rc = 0;
+    }
+    return rc;
+}
+
+// --- rect fill ---------------------------------------------------------------
+
+// apply mask 'm' to 'cnt' octets
+static inline void fill_run(uint8_t * d, int cnt, uint8_t m, int mode) {
+    int i;
+    if (mode == GFXUTIL_FILL_SET) {
+        if (m == 0xff) {
+            memset(d, 0xff, cnt);
+        } else {
+            for (i = 0 ; i < cnt ; i++)
+                d[i] |= m;
+        }
+    } else if (mode == GFXUTIL_FILL_CLEAR) {
+        if (m == 0xff) {
+            memset(d, 0, cnt);
+        } else {
+            for (i = 0 ; i < cnt ; i++)
+                d[i] &= (uint8_t)~m;
+        }
+    } else {
+        for (i = 0 ; i < cnt ; i++)
+            d[i] ^= m;
+    }
+}
+
+int gfxutil_fill_rect(uint8_t * fb, size_t fb_width, size_t fb_pages, int x, int y, int w, int h, int mode) {
+    int p0, p1, p;
+    uint8_t m0, m1;
+    if (!fb || mode < GFXUTIL_FILL_SET || mode > GFXUTIL_FILL_INVERT)
+        return -1;
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)fb_width) w = (int)fb_width - x;
+    if (y + h > (int)(fb_pages * FRAMEBUF_LINES_PER_PG)) h = (int)(fb_pages * FRAMEBUF_LINES_PER_PG) - y;
+    if (w <= 0 || h <= 0)
+        return 0;
+    p0 = y >> 3;
+    p1 = (y + h - 1) >> 3;
+    m0 = (uint8_t)(0xff << (y & 7));
+    m1 = (uint8_t)(0xff >> (7 - ((y + h - 1) & 7)));
+    fb += x;
+    if (p0 == p1) {
+        fill_run(fb + (p0 * fb_width), w, m0 & m1, mode);
+    } else {
+        fill_run(fb + (p0 * fb_width), w, m0, mode);
+        for (p = p0 + 1 ; p < p1 ; p++)
+            fill_run(fb + (p * fb_width), w, 0xff, mode);
+        fill_run(fb + (p1 * fb_width), w, m1, mode);
+    }
+    return (p1 - p0 + 1) * w;
+}
+
+// --- RLE bitmaps -------------------------------------------------------------
+
+// destination of one gfxutil_rle_blit()
+typedef struct rle_dst_type {
+    uint8_t * to;
+    int to_width;
+    int to_pages;
+    int at_x;
+    int at_y;
+    int overwrite;
+} rle_dst_t;
+
+// write 'cnt' decoded octets of source page 'p', starting at column 'c'. 'lit' 
+// points at literal octets or is NULL for 'cnt' repeats of 'v'.
+static void rle_put(const rle_dst_t * d, int p, int c, int cnt, const uint8_t * lit, uint8_t v) {
+    int x0 = d->at_x + c;
+    int x1 = x0 + cnt;
+    int y  = d->at_y + (p * FRAMEBUF_LINES_PER_PG);
+    int dp = row_to_page(y);
+    int n  = y - (dp * FRAMEBUF_LINES_PER_PG);
+    uint8_t * lo;
+    uint8_t * hi;
+    uint8_t klo, khi;
+    int i;
+
+    if (x0 < 0) {
+        if (lit) lit -= x0;
+        x0 = 0;
+    }
+    if (x1 > d->to_width)
+        x1 = d->to_width;
+    if (x0 >= x1)
+        return;
+    cnt = x1 - x0;
+    lo  = (dp >= 0 && dp < d->to_pages) ? d->to + (dp * d->to_width) + x0 : NULL;
+    hi  = (n && (dp + 1) >= 0 && (dp + 1) < d->to_pages) ? d->to + ((dp + 1) * d->to_width) + x0 : NULL;
+    klo = (d->overwrite) ? (uint8_t)~(0xff << n) : 0xff;
+    khi = (d->overwrite) ? (uint8_t)~(0xff >> (8 - n)) : 0xff;
+    if (lit) {
+        if (lo)
+            for (i = 0 ; i < cnt ; i++)
+                lo[i] = (lo[i] & klo) | (uint8_t)(lit[i] << n);
+        if (hi)
+            for (i = 0 ; i < cnt ; i++)
+                hi[i] = (hi[i] & khi) | (lit[i] >> (8 - n));
+    } else {
+        uint8_t vlo = (uint8_t)(v << n);
+        uint8_t vhi = (uint8_t)(v >> (8 - n));
+        if (lo)
+            for (i = 0 ; i < cnt ; i++)
+                lo[i] = (lo[i] & klo) | vlo;
+        if (hi)
+            for (i = 0 ; i < cnt ; i++)
+                hi[i] = (hi[i] & khi) | vhi;
+    }
+}
+
+int gfxutil_rle_blit(const uint8_t * rle, size_t from_width, size_t from_pages, bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, size_t to_pages) {
+    rle_dst_t d;
+    int w = (int)from_width;
+    int p = 0;
+    int c = 0;
+    if (!rle || !to || !from_width)
+        return 1;
+    d.to = to;
+    d.to_width = (int)to_width;
+    d.to_pages = (int)to_pages;
+    d.at_x = at_x;
+    d.at_y = at_y;
+    d.overwrite = overwrite;
+    while (p < (int)from_pages) {
+        uint8_t ctl = *rle++;
+        const uint8_t * lit = NULL;
+        uint8_t v = 0;
+        int len;
+        if (ctl & GFXUTIL_RLE_REPEAT) {
+            len = (ctl & ~GFXUTIL_RLE_REPEAT) + GFXUTIL_RLE_MIN_REPEAT;
+            v = *rle++;
+        } else {
+            len = ctl + 1;
+            lit = rle;
+            rle += len;
+        }
+        // runs can carry on into the next page
+        while (len && p < (int)from_pages) {
+            int seg = w - c;
+            if (seg > len)
+                seg = len;
+            rle_put(&d, p, c, seg, lit, v);
+            if (lit)
+                lit += seg;
+            len -= seg;
+            c += seg;
+            if (c == w) {
+                c = 0;
+                p ++;
             }
+        }
+    }
+    return 0;
+}
 
-            fb_start ++;
-            f_idx ++;
-            digwidth ++;
-            if (digwidth >= from_width) {
-                // re-calulate dest buffer index by jumping to the next page and back at the start left side again.
-                to_pg ++; // next page down
-                fb_start = (to_pg * to_width) + at_x; // re-calc starting point in dest buffer
-                digwidth = 0;
+int gfxutil_rle_encode(const uint8_t * from, size_t len, uint8_t * to, size_t to_len) {
+    size_t i = 0;
+    size_t o = 0;
+    if (!from || !to)
+        return -1;
+    while (i < len) {
+        size_t run = 1;
+        while ((i + run) < len && from[i + run] == from[i] && run < GFXUTIL_RLE_MAX_REPEAT)
+            run ++;
+        if (run >= GFXUTIL_RLE_MIN_REPEAT + 1) {
+            // a run of 2 is cheaper left inside a literal
+            if ((o + 2) > to_len)
+                return -1;
+            to[o++] = GFXUTIL_RLE_REPEAT | (uint8_t)(run - GFXUTIL_RLE_MIN_REPEAT);
+            to[o++] = from[i];
+            i += run;
+        } else {
+            size_t n = 0;
+            while ((i + n) < len && n < GFXUTIL_RLE_MAX_LITERAL) {
+                if ((i + n + 2) < len && from[i + n] == from[i + n + 1] && from[i + n] == from[i + n + 2])
+                    break; // a run starts here
+                n ++;
             }
+            if ((o + 1 + n) > to_len)
+                return -1;
+            to[o++] = (uint8_t)(n - 1);
+            memcpy(to + o, from + i, n);
+            o += n;
+            i += n;
         }
+    }
+    return (int)o;
+}
+
+// --- row-major <--> page format --------------------------------------------
+
+// Transpose the 8x8 bit matrix held in x, bit (8*i + j) <--> bit (8*j + i).
+// Octet i in, row of 8 pixels (LSB first) --> octet j out, column of 8 pixels.
+static inline uint64_t transpose8x8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+int gfxutil_rows_to_pages(const uint8_t * from, size_t width, size_t height, int bit_order, uint8_t * to) {
+    size_t stride = (width + 7) / 8;
+    size_t pages  = (height + 7) / 8;
+    size_t p, b;
+    if (!from || !to || !width || !height)
+        return 1;
+    for (p = 0 ; p < pages ; p++) {
+        size_t rows = (height - (p * 8) < 8) ? height - (p * 8) : 8;
+        const uint8_t * src = from + (p * 8 * stride);
+        uint8_t * dst = to + (p * width);
+        for (b = 0 ; b < stride ; b++) {
+            size_t cols = (width - (b * 8) < 8) ? width - (b * 8) : 8;
+            uint64_t x = 0;
+            size_t r, c;
+            for (r = 0 ; r < rows ; r++)
+                x |= (uint64_t)src[(r * stride) + b] << (r * 8);
+            x = transpose8x8(x);
+            // octet c is now the page octet of pixel column c (LSB first) or 7-c (MSB first)
+            if (bit_order == GFXUTIL_BITS_MSB_FIRST) {
+                for (c = 0 ; c < cols ; c++)
+                    dst[c] = (uint8_t)(x >> ((7 - c) * 8));
+            } else {
+                for (c = 0 ; c < cols ; c++)
+                    dst[c] = (uint8_t)(x >> (c * 8));
+            }
+            dst += 8;
+        }
+    }
+    return 0;
+}
+
+int gfxutil_pages_to_rows(const uint8_t * from, size_t width, size_t height, int bit_order, uint8_t * to) {
+    size_t stride = (width + 7) / 8;
+    size_t pages  = (height + 7) / 8;
+    size_t p, b;
+    if (!from || !to || !width || !height)
+        return 1;
+    for (p = 0 ; p < pages ; p++) {
+        size_t rows = (height - (p * 8) < 8) ? height - (p * 8) : 8;
+        const uint8_t * src = from + (p * width);
+        uint8_t * dst = to + (p * 8 * stride);
+        for (b = 0 ; b < stride ; b++) {
+            size_t cols = (width - (b * 8) < 8) ? width - (b * 8) : 8;
+            uint64_t x = 0;
+            size_t r, c;
+            if (bit_order == GFXUTIL_BITS_MSB_FIRST) {
+                for (c = 0 ; c < cols ; c++)
+                    x |= (uint64_t)src[c] << ((7 - c) * 8);
+            } else {
+                for (c = 0 ; c < cols ; c++)
+                    x |= (uint64_t)src[c] << (c * 8);
+            }
+            x = transpose8x8(x);
+            for (r = 0 ; r < rows ; r++)
+                dst[(r * stride) + b] = (uint8_t)(x >> (r * 8));
+            src += 8;
+        }
+    }
+    return 0;
+}
+
+// --- sprite cache -----------------------------------------------------------
+
+typedef struct sprslot_type {
+    const uint8_t * bmap;   /* key: source bitmap (raw or RLE), NULL := slot free */
+    uint16_t width;         /* key: source width                     */
+    uint8_t  pages;         /* key: source height, pages             */
+    uint8_t  shift;         /* key: rows shifted down, 1..7          */
+    uint32_t used;          /* LRU tick of the last use              */
+    uint8_t * data;         /* shifted bitmap, (pages + 1) high      */
+} sprslot_t;
+
+static sprslot_t * spr_slots = NULL;
+static uint8_t *   spr_pool = NULL;
+static size_t      spr_count = 0;
+static size_t      spr_slot_bytes = 0;
+static uint32_t    spr_tick = 0;
+static gfxutil_sprcache_stats_t spr_stats = {0};
+
+int gfxutil_sprcache_init(size_t slots, size_t slot_bytes) {
+    int rc = 1;
+    if (!spr_slots && slots && slot_bytes) {
+        spr_slots = (sprslot_t *)calloc(slots, sizeof(sprslot_t));
+        spr_pool  = (uint8_t *)malloc(slots * slot_bytes);
+        if (spr_slots && spr_pool) {
+            size_t i;
+            for (i = 0 ; i < slots ; i++)
+                spr_slots[i].data = spr_pool + (i * slot_bytes);
+            spr_count = slots;
+            spr_slot_bytes = slot_bytes;
+            rc = 0;
+        } else {
+            free(spr_slots);
+            free(spr_pool);
+            spr_slots = NULL;
+            spr_pool = NULL;
+        }
+    }
+    return rc;
+}
+
+void gfxutil_sprcache_flush(void) {
+    size_t i;
+    for (i = 0 ; i < spr_count ; i++)
+        spr_slots[i].bmap = NULL;
+}
+
+int gfxutil_sprcache_getStats(gfxutil_sprcache_stats_t * stats) {
+    int rc = 1;
+    if (stats) {
+        *stats = spr_stats;
         rc = 0;
     }
     return rc;
 }
 
+void gfxutil_sprcache_resetStats(void) {
+    memset(&spr_stats, 0, sizeof(spr_stats));
+}
+
+// find the slot holding (bmap, shift), filling the least recently used one on a miss
+static sprslot_t * sprcache_get(const uint8_t * bmap, int width, int pages, int shift, int rle) {
+    sprslot_t * lru = &spr_slots[0];
+    size_t i;
+    spr_tick ++;
+    for (i = 0 ; i < spr_count ; i++) {
+        sprslot_t * s = &spr_slots[i];
+        if (s->bmap == bmap && s->shift == shift && s->width == width && s->pages == pages) {
+            s->used = spr_tick;
+            spr_stats.hits ++;
+            return s;
+        }
+        if (!s->bmap) {
+            lru = s;    // free slots are taken first
+        } else if (lru->bmap && s->used < lru->used) {
+            lru = s;
+        }
+    }
+    spr_stats.misses ++;
+    if (lru->bmap)
+        spr_stats.evictions ++;
+    memset(lru->data, 0, width * (pages + 1));
+    if (rle)
+        gfxutil_rle_blit(bmap, width, pages, true, 0, shift, lru->data, width, pages + 1);
+    else
+        rect_xfer(bmap, width, pages, 0, 0, width, pages * FRAMEBUF_LINES_PER_PG,
+                  lru->data, width, pages + 1, 0, shift, XFER_COPY);
+    lru->bmap  = bmap;
+    lru->width = width;
+    lru->pages = pages;
+    lru->shift = shift;
+    lru->used  = spr_tick;
+    return lru;
+}
+
+static int sprcache_blit(const uint8_t * from, size_t from_width, size_t from_pages, bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, size_t to_pages, int rle) {
+    int shift = at_y - (row_to_page(at_y) * FRAMEBUF_LINES_PER_PG);
+    if (!from || !to)
+        return 1;
+    if (!spr_slots || !shift || (from_width * (from_pages + 1)) > spr_slot_bytes || from_pages > 0xfe) {
+        spr_stats.bypass ++;
+        if (rle)
+            return gfxutil_rle_blit(from, from_width, from_pages, overwrite, at_x, at_y, to, to_width, to_pages);
+        return gfxutil_blit(from, from_width, from_pages, overwrite, at_x, at_y, to, to_width, to_pages);
+    }
+    {
+        sprslot_t * s = sprcache_get(from, (int)from_width, (int)from_pages, shift, rle);
+        // source rows start at 'shift' in the slot, dest pages line up with slot pages
+        rect_xfer(s->data, s->width, s->pages + 1, 0, shift, 
+                  s->width, s->pages * FRAMEBUF_LINES_PER_PG,
+                  to, (int)to_width, (int)to_pages, at_x, at_y, 
+                  (overwrite) ? XFER_COPY : XFER_OR);
+    }
+    return 0;
+}
+
+int gfxutil_blit_cached(const uint8_t * from, size_t from_width, size_t from_pages, bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, size_t to_pages) {
+    return sprcache_blit(from, from_width, from_pages, overwrite, at_x, at_y, to, to_width, to_pages, 0);
+}
+
+int gfxutil_rle_blit_cached(const uint8_t * rle, size_t from_width, size_t from_pages, bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, size_t to_pages) {
+    return sprcache_blit(rle, from_width, from_pages, overwrite, at_x, at_y, to, to_width, to_pages, 1);
+}
+
 // static void digit_render(uint8_t xpos, uint8_t ypos, uint8_t dig) {
 //     uint8_t  fb_page  = ypos / FRAMEBUF_LINES_PER_PG;
 //     uint8_t  n        = ypos % FRAMEBUF_LINES_PER_PG; // line-misalignment in no. of bits. 0 := aligned
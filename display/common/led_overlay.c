@@ -36,6 +36,7 @@ static int         led_fastcopy_enabled = 0;  // set to 'true' to allow fast cop
 static size_t      drvr_screen_width = 0;
 static size_t      drvr_screen_height = 0;
 static size_t      drvr_screen_pages = 0;
+static uint8_t     led_layer_prio = 0;       // compositor layer the LED buffer is registered on
 static size_t  FRAMEBUF_LINES_PER_PG = 0; // TBD from driver
 #define DIGIT_WIDTH  17
 #define DIGIT_HEIGHT 32
@@ -52,6 +53,16 @@ static size_t      MAX_Y_POS = 0; // TBD from driver
 #define MAXVAL_4DIG  9999
 #define BLANK_DIGIT_IDX 0xf     /* set this value in ctx.dval[n] to blank digit n */
 #define CTX_WMARK    0x4C45444F
+
+// Keep shifted copies of the digit bitmaps for digits drawn at a y position
+// that is not page aligned, see gfxutil_blit_cached(). Uses
+// (LEDO_SPRCACHE_SLOTS * DIGIT_WIDTH * (DIGIT_PGHGT + 1)) bytes of heap.
+#ifndef LEDO_USE_SPRITE_CACHE
+  #define LEDO_USE_SPRITE_CACHE 0
+#endif
+#ifndef LEDO_SPRCACHE_SLOTS
+  #define LEDO_SPRCACHE_SLOTS   11  /* 0-9 + blank at one y position */
+#endif
 //static size_t        DIGIT_BUFLEN = 0; // TBD from driver
 
 // #if defined(DISP_SSD1309)
@@ -70,63 +81,47 @@ static size_t      MAX_Y_POS = 0; // TBD from driver
 //#define MAX_Y_POS    ((FRAMEBUF_P_HEIGHT-1) - DIGIT_HEIGHT)
 //#define DIGIT_BUFLEN (DIGIT_PGHGT * DIGIT_WIDTH)
 
-/* digit is blanked */
-static const uint8_t bmap_dig_blank[DIGIT_BUFLEN] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }; 
+/* Digit bitmaps, DIGIT_WIDTH x DIGIT_PGHGT pages, RLE compressed (see
+ * gfxutil_rle_blit() in cpyutils.h). 748 octets raw, 337 compressed. */
 
-static const uint8_t bmap_dig_0[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x3f, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f, 
-    0xfe, 0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe, 
-    0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_1[DIGIT_BUFLEN] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xfc, 0xf8, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_2[DIGIT_BUFLEN] = {
-    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x00, 0x00, 0x80, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f, 
-    0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 
-    0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x40, 0x00, 0x00 };
-static const uint8_t bmap_dig_3[DIGIT_BUFLEN] = {
-    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x00, 0x00, 0x80, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f, 
-    0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x40, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_4[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xfc, 0xf8, 
-    0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f, 
-    0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_5[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00, 
-    0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x00, 0x00, 
-    0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x40, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_6[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00, 
-    0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x00, 0x00, 
-    0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_7[DIGIT_BUFLEN] = {
-    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_8[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f, 
-    0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f };
-static const uint8_t bmap_dig_9[DIGIT_BUFLEN] = {
-    0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8, 
-    0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f, 
-    0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe, 
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f };
+/* digit is blanked */
+static const uint8_t bmap_dig_blank[] = {
+    0xc2, 0x00 };
+static const uint8_t bmap_dig_0[] = {
+    0x02, 0xf8, 0xfc, 0xfa, 0x89, 0x07, 0x05, 0xfa, 0xfc, 0xf8, 0x3f, 0x7f, 0x3f, 0x89, 0x00, 0x05, 0x3f,
+    0x7f, 0x3f, 0xfe, 0xff, 0xfe, 0x89, 0x00, 0x05, 0xfe, 0xff, 0xfe, 0x1f, 0x3f, 0x5f, 0x89, 0xe0, 0x02,
+    0x5f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_1[] = {
+    0x8c, 0x00, 0x02, 0xf8, 0xfc, 0xf8, 0x8c, 0x00, 0x02, 0x3f, 0x7f, 0x3f, 0x8c, 0x00, 0x02, 0xfe, 0xff,
+    0xfe, 0x8c, 0x00, 0x02, 0x1f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_2[] = {
+    0x02, 0x00, 0x00, 0x02, 0x89, 0x07, 0x05, 0xfa, 0xfc, 0xf8, 0x00, 0x00, 0x80, 0x89, 0xc0, 0x05, 0xbf,
+    0x7f, 0x3f, 0xfe, 0xff, 0xfe, 0x89, 0x01, 0x81, 0x00, 0x02, 0x1f, 0x3f, 0x5f, 0x89, 0xe0, 0x02, 0x40,
+    0x00, 0x00 };
+static const uint8_t bmap_dig_3[] = {
+    0x02, 0x00, 0x00, 0x02, 0x89, 0x07, 0x05, 0xfa, 0xfc, 0xf8, 0x00, 0x00, 0x80, 0x89, 0xc0, 0x02, 0xbf,
+    0x7f, 0x3f, 0x81, 0x00, 0x89, 0x01, 0x05, 0xfe, 0xff, 0xfe, 0x00, 0x00, 0x40, 0x89, 0xe0, 0x02, 0x5f,
+    0x3f, 0x1f };
+static const uint8_t bmap_dig_4[] = {
+    0x02, 0xf8, 0xfc, 0xf8, 0x89, 0x00, 0x05, 0xf8, 0xfc, 0xf8, 0x3f, 0x7f, 0xbf, 0x89, 0xc0, 0x02, 0xbf,
+    0x7f, 0x3f, 0x81, 0x00, 0x89, 0x01, 0x02, 0xfe, 0xff, 0xfe, 0x8c, 0x00, 0x02, 0x1f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_5[] = {
+    0x02, 0xf8, 0xfc, 0xfa, 0x89, 0x07, 0x05, 0x02, 0x00, 0x00, 0x3f, 0x7f, 0xbf, 0x89, 0xc0, 0x00, 0x80,
+    0x83, 0x00, 0x89, 0x01, 0x05, 0xfe, 0xff, 0xfe, 0x00, 0x00, 0x40, 0x89, 0xe0, 0x02, 0x5f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_6[] = {
+    0x02, 0xf8, 0xfc, 0xfa, 0x89, 0x07, 0x05, 0x02, 0x00, 0x00, 0x3f, 0x7f, 0xbf, 0x89, 0xc0, 0x05, 0x80,
+    0x00, 0x00, 0xfe, 0xff, 0xfe, 0x89, 0x01, 0x05, 0xfe, 0xff, 0xfe, 0x1f, 0x3f, 0x5f, 0x89, 0xe0, 0x02,
+    0x5f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_7[] = {
+    0x02, 0x00, 0x00, 0x02, 0x89, 0x07, 0x02, 0xfa, 0xfc, 0xf8, 0x8c, 0x00, 0x02, 0x3f, 0x7f, 0x3f, 0x8c,
+    0x00, 0x02, 0xfe, 0xff, 0xfe, 0x8c, 0x00, 0x02, 0x1f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_8[] = {
+    0x02, 0xf8, 0xfc, 0xfa, 0x89, 0x07, 0x05, 0xfa, 0xfc, 0xf8, 0x3f, 0x7f, 0xbf, 0x89, 0xc0, 0x05, 0xbf,
+    0x7f, 0x3f, 0xfe, 0xff, 0xfe, 0x89, 0x01, 0x05, 0xfe, 0xff, 0xfe, 0x1f, 0x3f, 0x5f, 0x89, 0xe0, 0x02,
+    0x5f, 0x3f, 0x1f };
+static const uint8_t bmap_dig_9[] = {
+    0x02, 0xf8, 0xfc, 0xfa, 0x89, 0x07, 0x05, 0xfa, 0xfc, 0xf8, 0x3f, 0x7f, 0xbf, 0x89, 0xc0, 0x02, 0xbf,
+    0x7f, 0x3f, 0x81, 0x00, 0x89, 0x01, 0x02, 0xfe, 0xff, 0xfe, 0x8c, 0x00, 0x02, 0x1f, 0x3f, 0x1f };
 
 static const uint8_t * bmaps[] = {
     bmap_dig_blank, /* zero index = blank digit ! */
@@ -233,6 +228,7 @@ int led0_init(uint8_t layer_prio) {
             led_linebuffer = (uint8_t *)malloc(led_bufferlen);
             if (led_linebuffer) {
                 gfxutil_fb_clear(led_linebuffer, led_bufferlen, led_fastcopy_enabled);
+                led_layer_prio = layer_prio;
                 rc = gfx_setFrameBufferLayerPrio(led_linebuffer,layer_prio, FB_NO_MASK);
                 if (rc == EXIT_SUCCESS) {
                     size_t i;
@@ -243,6 +239,10 @@ int led0_init(uint8_t layer_prio) {
                     for (i = 0 ; i < MAX_LEDO_SESSIONS ; i++) {
                         memset( led_session+i, 0, sizeof(led_ctx_t) );
                     }
+#if (LEDO_USE_SPRITE_CACHE == 1)
+                    // may already be running for other users, blits bypass it if not
+                    gfxutil_sprcache_init(LEDO_SPRCACHE_SLOTS, DIGIT_WIDTH * (DIGIT_PGHGT + 1));
+#endif
                 }
             }
         } 
@@ -298,8 +298,13 @@ static int digit_render(uint8_t xpos, uint8_t ypos, uint8_t dig) {
     int rc = 1;
     if (led_linebuffer) {
         const uint8_t * bm = (dig == BLANK_DIGIT_IDX) ? bmaps[0] : bmaps[dig+1];
-        rc = gfxutil_blit(bm, DIGIT_WIDTH, DIGIT_PGHGT, true, xpos, ypos, 
+#if (LEDO_USE_SPRITE_CACHE == 1)
+        rc = gfxutil_rle_blit_cached(bm, DIGIT_WIDTH, DIGIT_PGHGT, true, xpos, ypos, 
             led_linebuffer, drvr_screen_width, drvr_screen_pages);
+#else
+        rc = gfxutil_rle_blit(bm, DIGIT_WIDTH, DIGIT_PGHGT, true, xpos, ypos, 
+            led_linebuffer, drvr_screen_width, drvr_screen_pages);
+#endif
     }
     return rc;
 }
@@ -358,6 +363,8 @@ int ledo_refresh(void * _ctx) {
             }
             // call the underlying compositor to merge layers and 
             // update display
+            GFX_STATS_LAYER_UPDATE(led_layer_prio);
+            gfx_addDamage(ctx->xpos, ctx->ypos, xposn - ctx->xpos, DIGIT_HEIGHT);
             rc = gfx_displayRefresh();
         }
     }
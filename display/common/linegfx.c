@@ -41,6 +41,7 @@ static int         gfx_fastcopy_enabled = 0;  // set to 'true' to allow fast cop
 static size_t      drvr_screen_width = 0;
 static size_t      drvr_screen_height = 0;
 static size_t      drvr_screen_pages = 0;
+static uint8_t     gfx_layer_prio = 0;       // compositor layer the line buffer is registered on
 
 // call after driver is mounted and started to get info
 // Returns:
@@ -58,6 +59,7 @@ int lgfx_init(uint8_t layer_prio) {
             gfx_linebuffer = (uint8_t *)malloc(gfx_bufferlen);
             if (gfx_linebuffer) {
                 gfxutil_fb_clear(gfx_linebuffer, gfx_bufferlen, gfx_fastcopy_enabled);
+                gfx_layer_prio = layer_prio;
                 rc = gfx_setFrameBufferLayerPrio(gfx_linebuffer,layer_prio, FB_NO_MASK);
             }
         } else {
@@ -163,6 +165,8 @@ static int lgfx_liney(uint8_t x, uint8_t y, uint8_t len, uint8_t c) {
 //      0 := OK, 1:= Error
 int lgfx_clear(void) {
     lgfx_clearbuf();
+    GFX_STATS_LAYER_UPDATE(gfx_layer_prio);
+    gfx_addDamageFull();
     return 0;
 }
 
@@ -186,6 +190,9 @@ int lgfx_line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t c) {
         int ax = (dx >= 0) ? dx : (-1)*dx; // abs x dist
         int ay = (dy >= 0) ? dy : (-1)*dy; // abs y dist
 
+        GFX_STATS_LAYER_UPDATE(gfx_layer_prio);
+        gfx_addDamage((x1 < x2) ? x1 : x2, (y1 < y2) ? y1 : y2, ax + 1, ay + 1);
+
         // dx        := line projection on x-axis (signed)
         // ax        := |dx| (absolute len)
         // dy, ay    := same a dx,ax except for y-axis
@@ -252,25 +259,27 @@ int lgfx_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t c) {
 }
 
 int lgfx_filled_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t c) {
-    int rc = lgfx_box(x1, y1, x2, y2, c);
-    if (!rc) {
-        size_t i;
-        uint8_t ya = y1;
-        uint8_t yb = y2;
-        if (yb < ya) {
-            ya = y2;
-            yb = y1;
-        }
-        for (i = ya+1 ; i < yb ; i++) {
-            rc = lgfx_line(x1,i,x2,i,c);
-            if (rc) {
-                break;
-            }
-        }
+    int rc = 1;
+    if ((x1 < drvr_screen_width) && (x2 < drvr_screen_width) && 
+        (y1 < drvr_screen_height) && (y2 < drvr_screen_height) && 
+        (c >= COLOUR_BLK) && (c <= COLOUR_WHT)) {
+        int xa = (x1 < x2) ? x1 : x2;
+        int ya = (y1 < y2) ? y1 : y2;
+        int w  = ((x1 < x2) ? x2 - x1 : x1 - x2) + 1;
+        int h  = ((y1 < y2) ? y2 - y1 : y1 - y2) + 1;
+        GFX_STATS_LAYER_UPDATE(gfx_layer_prio);
+        gfx_addDamage(xa, ya, w, h);
+        gfxutil_fill_rect(gfx_linebuffer, drvr_screen_width, drvr_screen_pages, xa, ya, w, h,
+            (c != COLOUR_WHT) ? GFXUTIL_FILL_SET : GFXUTIL_FILL_CLEAR);
+        rc = 0;
     }
     return rc;
 }
 
+int lgfx_clear_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
+    return lgfx_filled_box(x1, y1, x2, y2, COLOUR_WHT);
+}
+
 // Draw an Arc
 //  Inputs: (cx,cy)     centre of the arc
 //          r           radius (pixels)
@@ -330,48 +339,19 @@ int lgfx_circle(uint8_t cx, uint8_t cy, uint8_t r, uint8_t c) {
 // -----------------------------------------------------------------
 int lgfx_bgraph(uint8_t x, uint8_t y, uint8_t h, uint8_t len, uint8_t fill, uint8_t c) {
     int rc = 1;
-    volatile int i,j,n;
-    uint8_t * glb = &(gfx_linebuffer[x]);
-    uint8_t * pi[8]; // the 8 page pointers
-    uint8_t   mpage[8];  // bitmask for each page.. where the active area of the graph is. if zero then page not int he graph.
-    
-    // optimize this graph to make use of the underlying screen memory mapping
-    // where pages are stacks of 8-bit columns in a horizontal row 128 elements 
-    // wide.
+    // pages are stacks of 8-bit columns in a horizontal row, the kernel
+    // works out the page masks once for the bar and the empty part.
     if ((x+len < drvr_screen_width) && (y+h < drvr_screen_height) && 
         (c >= COLOUR_BLK) && (c <= COLOUR_WHT) && (h > 0) && (len > 0)) {
-        for (i=0 ; i<8 ; i++ ) {
-            pi[i] = glb;
-            glb += drvr_screen_width;
-            // work out the bit masks
-            mpage[i] = 0;
-            n = i << 3; //abs posn of topmost pixel in this page (range:0..63)
-            for (j = 0 ; j < 8 ; j++ ) {
-                if ((n+j) >= y && (n+j) <= (y+h-1)) {
-                    mpage[i] |= 1<<j; // this pixel is in the bar, set its mask
-                }
-            }
-        }
-        i = 0;
-        while (len) {
-            // work through total length of bar graph
-            for (j=0 ; j < 8 ; j++ ) {
-                if (mpage[j]) {
-                    if (i < fill) {
-                        // add bar
-                        *(pi[j]) |= mpage[j];
-                    } else {
-                        // remove bar
-                        *(pi[j]) &= (uint8_t)~(mpage[j]);
-                    }
-                }
-            }
-            len --;
-            i ++;
-            for (j=0 ; j < 8 ; j++ ) {
-                pi[j] ++; // adv. to next pixel column over in each page
-            }
-        }
+        uint8_t on = (fill < len) ? fill : len;
+        GFX_STATS_LAYER_UPDATE(gfx_layer_prio);
+        gfx_addDamage(x, y, len, h);
+        // add bar
+        gfxutil_fill_rect(gfx_linebuffer, drvr_screen_width, drvr_screen_pages, 
+            x, y, on, h, GFXUTIL_FILL_SET);
+        // remove bar
+        gfxutil_fill_rect(gfx_linebuffer, drvr_screen_width, drvr_screen_pages, 
+            x + on, y, len - on, h, GFXUTIL_FILL_CLEAR);
         rc = 0;
     }
     return rc;
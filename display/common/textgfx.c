@@ -22,9 +22,13 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <textgfx.h>
 #include <cpyutils.h>
 #include <gfxDriverLowPriv.h>
+#if (TEXTGFX_STDIO_DRIVER == 1)
+#include "pico/stdio/driver.h"
+#endif
 
 // The following chars are not looked up but instead directly
 // affect the screen cursor: \n, \r, 'DEL'
@@ -297,6 +301,225 @@ static const uint8_t font_5x7[] = {
 #endif
 };
 
+// default font descriptor, drawn through the glyph cells below
+const gfxfont_t gfxfont_5x7 = {
+    .data    = font_5x7,
+    .widths  = NULL,
+    .offsets = NULL,
+    .first   = 0,
+    .last    = 0xFE,
+    .width   = FONT_W,
+    .height  = 7,
+    .pages   = 1,
+    .spacing = 1,
+    .missing = ' ',
+};
+
+// Glyph cells ----------------------------------------------------------------
+// A glyph is drawn from a cell holding the 5 font columns already masked (msb,
+// bottom of font, blanked) with a blank column on both sides:
+//   [0] blank  [1..5] font  [6] blank  [7] pad
+// Static text copies [1..6], floating text boxes [0..5].
+// With TEXTGFX_USE_GLYPH_ATLAS=1 the cells for TEXTGFX_ATLAS_FIRST .. 
+// TEXTGFX_ATLAS_LAST are unpacked into RAM once at text_init(). Other chars,
+// or all of them if the atlas is off or could not be allocated, are unpacked
+// from the flash font on each draw.
+#ifndef TEXTGFX_USE_GLYPH_ATLAS
+  #define TEXTGFX_USE_GLYPH_ATLAS 0
+#endif
+#ifndef TEXTGFX_ATLAS_FIRST
+  #define TEXTGFX_ATLAS_FIRST 0x20
+#endif
+#ifndef TEXTGFX_ATLAS_LAST
+  #define TEXTGFX_ATLAS_LAST  0x7E
+#endif
+#define GLYPH_CELL_LEN  8
+
+static void glyph_unpack(uint8_t c, uint8_t * cell) {
+	const uint8_t * fcol = &(font_5x7[c * FONT_W]);
+	int j;
+	cell[0] = 0;
+	for ( j = 0 ; j < FONT_W ; j++ )
+		cell[j + 1] = fcol[j] & 0x7F;
+	cell[FONT_W + 1] = 0;
+	cell[FONT_W + 2] = 0;
+}
+
+#if (TEXTGFX_USE_GLYPH_ATLAS == 1)
+static uint8_t * glyph_atlas = NULL;
+
+static void glyph_atlas_init(void) {
+	int c;
+	if (glyph_atlas == NULL) {
+		glyph_atlas = (uint8_t *)malloc((TEXTGFX_ATLAS_LAST - TEXTGFX_ATLAS_FIRST + 1) * GLYPH_CELL_LEN);
+		if (glyph_atlas) {
+			for ( c = TEXTGFX_ATLAS_FIRST ; c <= TEXTGFX_ATLAS_LAST ; c++ )
+				glyph_unpack((uint8_t)c, glyph_atlas + ((c - TEXTGFX_ATLAS_FIRST) * GLYPH_CELL_LEN));
+		}
+	}
+}
+#endif
+
+// Extended charset. Text cells 0x80 .. 0xFE then hold charset glyph 
+// (c - CHARSET_CELL), unpacked on first use into a cell of the LRU glyph 
+// cache. Same cell layout as above.
+#ifndef TEXTGFX_GLYPH_CACHE_SLOTS
+  #define TEXTGFX_GLYPH_CACHE_SLOTS 8
+#endif
+#define CHARSET_CELL    0x80
+
+typedef struct glyph_slot_type {
+	uint32_t used;              /* cache clock of the last use, 0 := empty */
+	uint8_t  glyph;
+	uint8_t  cell[GLYPH_CELL_LEN];
+} glyph_slot_t;
+
+static const gfxcharset_t * txt_charset = NULL;
+static glyph_slot_t * glyph_cache = NULL;
+static uint32_t glyph_clock = 0;
+
+// unpack charset glyph 'g', 7 bit columns from the packed bit stream
+static void charset_unpack(uint8_t g, uint8_t * cell) {
+	const uint8_t * d = txt_charset->data;
+	uint32_t bit = (uint32_t)g * FONT_W * GFXCHARSET_COL_BITS;
+	int j;
+	cell[0] = 0;
+	for ( j = 0 ; j < FONT_W ; j++ ) {
+		uint32_t v = d[bit >> 3] | ((uint32_t)d[(bit >> 3) + 1] << 8);
+		cell[j + 1] = (uint8_t)(v >> (bit & 7)) & 0x7F;
+		bit += GFXCHARSET_COL_BITS;
+	}
+	cell[FONT_W + 1] = 0;
+	cell[FONT_W + 2] = 0;
+}
+
+// cell of text cell code 'c' (>= CHARSET_CELL), from the cache or unpacked 
+// into its least recently used slot
+static const uint8_t * charset_cell(uint8_t c) {
+	glyph_slot_t * lru = glyph_cache;
+	uint8_t g = c - CHARSET_CELL;
+	int i;
+	glyph_clock ++;
+	for ( i = 0 ; i < TEXTGFX_GLYPH_CACHE_SLOTS ; i++ ) {
+		glyph_slot_t * slot = &(glyph_cache[i]);
+		if (slot->used && slot->glyph == g) {
+			slot->used = glyph_clock;
+			return slot->cell;
+		}
+		if (slot->used < lru->used)
+			lru = slot;
+	}
+	lru->glyph = g;
+	lru->used = glyph_clock;
+	if (g < txt_charset->glyph_count) {
+		charset_unpack(g, lru->cell);
+	} else {
+		memset(lru->cell, 0, GLYPH_CELL_LEN);
+	}
+	return lru->cell;
+}
+
+// text cell code of code point 'cp', '?' if not in the charset
+static uint8_t charset_lookup(uint32_t cp) {
+	const gfxcharset_range_t * r = txt_charset->ranges;
+	int lo = 0;
+	int hi = (int)txt_charset->range_count - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (cp < r[mid].first) {
+			hi = mid - 1;
+		} else if (cp >= (r[mid].first + r[mid].count)) {
+			lo = mid + 1;
+		} else {
+			return (uint8_t)(CHARSET_CELL + r[mid].glyph + (cp - r[mid].first));
+		}
+	}
+	return '?';
+}
+
+// UTF-8 decoder, one per text sink
+typedef struct utf8_dec_type {
+	uint32_t cp;                /* code point so far */
+	uint8_t  need;              /* # continuation octets still to come */
+} utf8_dec_t;
+
+// next octet 'b' of text. Returns the text cell code or -1 while a sequence 
+// is not complete. Without a charset the octets are the codes.
+static int utf8_cell(utf8_dec_t * d, uint8_t b) {
+	if (!txt_charset || b < 0x80) {
+		d->need = 0;
+		return b;
+	}
+	if ((b & 0xC0) == 0x80) {
+		if (!d->need)
+			return '?'; // stray continuation
+		d->cp = (d->cp << 6) | (b & 0x3F);
+		return (--d->need) ? -1 : charset_lookup(d->cp);
+	}
+	if ((b & 0xE0) == 0xC0) {
+		d->cp = b & 0x1F;
+		d->need = 1;
+	} else if ((b & 0xF0) == 0xE0) {
+		d->cp = b & 0x0F;
+		d->need = 2;
+	} else if ((b & 0xF8) == 0xF0) {
+		d->cp = b & 0x07;
+		d->need = 3;
+	} else {
+		d->need = 0;
+		return '?';
+	}
+	return -1;
+}
+
+// return the cell for char 'c'. 'tmp' (GLYPH_CELL_LEN octets) holds it when 
+// it is not in the atlas.
+static const uint8_t * glyph_cell(uint8_t c, uint8_t * tmp) {
+	if (c >= CHARSET_CELL && txt_charset)
+		return charset_cell(c);
+#if (TEXTGFX_USE_GLYPH_ATLAS == 1)
+	if (glyph_atlas && c >= TEXTGFX_ATLAS_FIRST && c <= TEXTGFX_ATLAS_LAST)
+		return glyph_atlas + ((c - TEXTGFX_ATLAS_FIRST) * GLYPH_CELL_LEN);
+#endif
+	glyph_unpack(c, tmp);
+	return tmp;
+}
+
+// Attributes -----------------------------------------------------------------
+// Applied to the glyph column octets as they are drawn. Underline sets the
+// bottom row, inverse flips the whole cell. A blinking cell is drawn blank in
+// the off phase of textgfx_blink_tick().
+static uint8_t blink_on = 1;
+
+// 'n' columns of cell 'g' with attributes 'a', in 'to' unless there are none
+static const uint8_t * attr_cell(const uint8_t * g, uint8_t a, uint8_t * to, int n) {
+	uint8_t ul  = (a & TEXT_ATTR_UNDERLINE) ? 0x80 : 0x00;
+	uint8_t inv = (a & TEXT_ATTR_INVERSE) ? 0xFF : 0x00;
+	int i;
+	if (!a)
+		return g;
+	if ((a & TEXT_ATTR_BLINK) && !blink_on) {
+		memset(to, 0, n);
+	} else {
+		for ( i = 0 ; i < n ; i++ )
+			to[i] = (g[i] | ul) ^ inv;
+	}
+	return to;
+}
+
+// font_draw() column 'v' of 'rows' rows with attributes 'a', the underline
+// is 'ul' rows thick
+static uint64_t attr_col(uint64_t v, uint8_t a, int rows, int ul) {
+	uint64_t cell = ((uint64_t)1 << rows) - 1;
+	if ((a & TEXT_ATTR_BLINK) && !blink_on)
+		return 0;
+	if (a & TEXT_ATTR_UNDERLINE)
+		v |= cell & ~(cell >> ul);
+	if (a & TEXT_ATTR_INVERSE)
+		v ^= cell;
+	return v;
+}
+
 // NEW - text now renders into its own private
 //       frame buffer and does not directly use the
 //       driver's buffer. This allows for priority
@@ -317,6 +540,18 @@ static size_t fb_pix_cols = 0;          /* aka pixel width */
 static size_t fb_pix_height = 0;	    /* vertical pixel | row count */
 static size_t fb_page_count = 0;        /* number of vertical pages, 8 rows per page  */ 
 static uint8_t fb_fastcopy_enabled = 0; /* if true then faster framebuffer operations are possible, eg. clear. */
+static uint8_t txt_layer_prio = 0;      /* compositor layer the text framebuffer is registered on */
+
+// A page format pixel buffer with its mask after it, what font_draw() writes
+// into: the text framebuffer or a floating box's tile.
+typedef struct txt_canvas_type {
+	uint8_t * px;
+	uint8_t * mask;
+	int       cols;
+	int       pages;
+} txt_canvas_t;
+static txt_canvas_t txt_canvas = {0};   /* the text framebuffer, set by text_init() */
+
 
 // Start the text layer of graphics processing.
 int text_init(uint8_t layer_prio) {
@@ -332,8 +567,16 @@ int text_init(uint8_t layer_prio) {
 			txt_framebuffer = (uint8_t *)malloc(txt_framebuffer_len);
 			if (txt_framebuffer) {
 				txtmask_fb_start = txt_framebuffer + fb_txt_seglen; // mask in the second half
+				txt_canvas.px = txt_framebuffer;
+				txt_canvas.mask = txtmask_fb_start;
+				txt_canvas.cols = (int)fb_pix_cols;
+				txt_canvas.pages = (int)fb_page_count;
 				gfxutil_fb_clear(txt_framebuffer, txt_framebuffer_len, fb_fastcopy_enabled);
 				// returns 0 on success.
+				txt_layer_prio = layer_prio;
+#if (TEXTGFX_USE_GLYPH_ATLAS == 1)
+				glyph_atlas_init(); // NULL on no memory, then glyphs come from flash
+#endif
 				rc = gfx_setFrameBufferLayerPrio(txt_framebuffer, layer_prio, FB_HAS_MASK); // this one uses a mask
 			}
 		} else {
@@ -344,6 +587,144 @@ int text_init(uint8_t layer_prio) {
 }
 
 
+// Fonts ----------------------------------------------------------------------
+// Fonts other than gfxfont_5x7, and any font scaled up, are drawn column by 
+// column with font_draw().
+
+// Scaling. A font column is stretched 2x, 3x or 4x down by looking each of its
+// bytes up in a bit expansion table, every bit becomes 'scale' bits. The
+// expanded column is then written 'scale' times side by side.
+#define TEXT_SCALE_MAX  4
+#define BX(b,s,m)   ( (((b) & 0x01) ? (m) : 0)            | (((b) & 0x02) ? ((m) << (s)) : 0)     | \
+                      (((b) & 0x04) ? ((m) << (2*(s))) : 0) | (((b) & 0x08) ? ((m) << (3*(s))) : 0) | \
+                      (((b) & 0x10) ? ((m) << (4*(s))) : 0) | (((b) & 0x20) ? ((m) << (5*(s))) : 0) | \
+                      (((b) & 0x40) ? ((m) << (6*(s))) : 0) | (((b) & 0x80) ? ((m) << (7*(s))) : 0) )
+#define BX4(b,s,m)   BX(b,s,m), BX((b)+1,s,m), BX((b)+2,s,m), BX((b)+3,s,m)
+#define BX16(b,s,m)  BX4(b,s,m), BX4((b)+4,s,m), BX4((b)+8,s,m), BX4((b)+12,s,m)
+#define BX64(b,s,m)  BX16(b,s,m), BX16((b)+16,s,m), BX16((b)+32,s,m), BX16((b)+48,s,m)
+#define BX256(s,m)   BX64(0,s,m), BX64(64,s,m), BX64(128,s,m), BX64(192,s,m)
+
+static const uint16_t bit_x2[256] = { BX256(2, 0x3u) };
+static const uint32_t bit_x3[256] = { BX256(3, 0x7u) };
+static const uint32_t bit_x4[256] = { BX256(4, 0xFu) };
+
+// font column byte 'b' stretched down by 'scale', 8 x 'scale' bits
+static uint32_t bit_expand(uint8_t b, int scale) {
+	switch (scale) {
+		case 2:  return bit_x2[b];
+		case 3:  return bit_x3[b];
+		case 4:  return bit_x4[b];
+		default: return b;
+	}
+}
+
+static int font_valid(const gfxfont_t * font) {
+	return (font && font->data && font->pages >= 1 && font->pages <= 4 && 
+		font->height >= 1 && font->height <= (font->pages * 8) && font->width >= 1 &&
+		font->first <= font->last && (!font->widths == !font->offsets) &&
+		font->missing >= font->first && font->missing <= font->last);
+}
+
+// glyph of char 'c', '*w' gets its width
+static const uint8_t * font_glyph(const gfxfont_t * font, uint8_t c, uint8_t * w) {
+	if (font == &gfxfont_5x7 && c >= CHARSET_CELL && txt_charset) {
+		*w = FONT_W;
+		return charset_cell(c) + 1;
+	}
+	if (c < font->first || c > font->last)
+		c = font->missing;
+	c -= font->first;
+	if (font->widths) {
+		*w = font->widths[c];
+		return font->data + font->offsets[c];
+	}
+	*w = font->width;
+	return font->data + ((uint32_t)c * font->width * font->pages);
+}
+
+// columns taken by char 'c', glyph plus spacing
+static int font_advance(const gfxfont_t * font, uint8_t c) {
+	uint8_t w;
+	font_glyph(font, c, &w);
+	return w + font->spacing;
+}
+
+// cell size, widest advance and the full page height
+static int font_cell_w(const gfxfont_t * font) {
+	return font->width + font->spacing;
+}
+
+static int font_cell_h(const gfxfont_t * font) {
+	return font->pages * 8;
+}
+
+static int font_min_advance(const gfxfont_t * font) {
+	int c, a, min = font_cell_w(font);
+	for ( c = font->first ; c <= font->last ; c++ ) {
+		a = font_advance(font, (uint8_t)c);
+		if (a < min)
+			min = a;
+	}
+	return (min > 0) ? min : 1;
+}
+
+// font pages x 'scale' must fit the 32 bit expanded column
+static int font_scale_ok(const gfxfont_t * font, int scale) {
+	return (scale >= 1 && scale <= TEXT_SCALE_MAX && (font->pages * scale) <= 4);
+}
+
+// mask written by font_draw() under the cell
+#define FONT_MASK_NONE  0   /* cleared */
+#define FONT_MASK_CELL  1   /* set, the whole cell (opaque) */
+#define FONT_MASK_GLYPH 2   /* the lit pixels only (transparent) */
+
+// draw char 'c' 'scale' times enlarged with attributes 'a' and its top left at
+// pixel (x,y) into canvas 'cv'. The whole cell height is drawn 
+// (opaque), columns at 'xlim' and right of it are clipped. 'c' = 0 is no 
+// character, a blank as wide as 'missing'. The mask under the cell is set as
+// 'm' (FONT_MASK_*) says.
+// Returns the advance, # columns taken.
+static int font_draw(const txt_canvas_t * cv, const gfxfont_t * font, uint8_t c, int x, int y, int xlim, int m, int scale, uint8_t a) {
+	uint8_t w;
+	const uint8_t * g = font_glyph(font, c, &w);
+	int adv = (w + font->spacing) * scale;
+	int n = y & 7;                          // rows shifted down into the next page
+	int pg = y >> 3;
+	uint64_t hmask = ((uint64_t)1 << (font->height * scale)) - 1;
+	uint64_t cmask = (((uint64_t)1 << (font_cell_h(font) * scale)) - 1) << n;
+	uint64_t mv;
+	int col, p, k, fx;
+	if (xlim > cv->cols)
+		xlim = cv->cols;
+	for ( col = 0 ; (col * scale) < adv && (x + (col * scale)) < xlim ; col++ ) {
+		uint64_t v = 0;
+		if (c && col < w) {
+			for ( p = 0 ; p < font->pages ; p++ )
+				v |= (uint64_t)bit_expand(g[(p * w) + col], scale) << (p * 8 * scale);
+			v &= hmask;
+		}
+		if (a)
+			v = attr_col(v, a, font_cell_h(font) * scale, scale);
+		v <<= n;
+		mv = (m == FONT_MASK_GLYPH) ? v : ((m) ? cmask : 0);
+		for ( k = 0 ; k < scale ; k++ ) {
+			// the same column, 'scale' times
+			fx = x + (col * scale) + k;
+			if (fx < 0)
+				continue;
+			if (fx >= xlim)
+				break;
+			for ( p = 0 ; (cmask >> (p * 8)) && (pg + p) < cv->pages ; p++ ) {
+				uint32_t i = ((pg + p) * cv->cols) + fx;
+				uint8_t cm = (uint8_t)(cmask >> (p * 8));
+				cv->px[i] = (cv->px[i] & ~cm) | (uint8_t)(v >> (p * 8));
+				cv->mask[i] = (cv->mask[i] & ~cm) | ((uint8_t)(mv >> (p * 8)) & cm);
+			}
+		}
+	}
+	return adv;
+}
+
 // PUBLIC Display driver stack pointer is 'g_llGfxDrvr'
 
 // x,y CURRENT cursor position (text box)
@@ -357,20 +738,55 @@ static uint8_t char_height = (uint8_t)-1;
 // Operation Modes
 static uint8_t txt_mode = 0;
 static uint8_t txt_wrap = 0;
+// Terminal (scroll) mode. text_buffer is then a ring of lines, 'tb_head' is
+// the line shown on top. In SET_TEXTSCROLL_HW mode the lines stay on their
+// page and the panel's display start line does the scroll.
+static uint8_t txt_scroll = SET_TEXTSCROLL_OFF;
+static uint8_t tb_head = 0;
+static size_t  hw_start_line = 0;   /* start line the panel is set to */
+// Scroll region, lines sr_top .. sr_bot scroll, the others stay put
+static uint8_t sr_top = 0;
+static uint8_t sr_bot = 0;
+// Font of the static text box, proportional ones are laid out by pixels
+static const gfxfont_t * txt_font = &gfxfont_5x7;
+static uint8_t txt_prop = 0;
+static utf8_dec_t txt_utf8 = {0};
+static uint8_t txt_scale = 1;           /* 1 .. TEXT_SCALE_MAX, see textgfx_set_scale() */
+static uint8_t txt_attr = TEXT_ATTR_NONE;   /* given to the chars placed */
+static uint8_t txt_has_blink = 0;           /* a cell may have TEXT_ATTR_BLINK */
 // Text Buffer, created once we know the geometry of the display
 static char * text_buffer = NULL; 
+static uint8_t * attr_buffer = NULL;    /* attributes of each cell in text_buffer */
 static size_t textBufLen = 0;
 // Some info on the graphics framebuffer and the alignment
 // of the text buffer over it
 static uint32_t tb_left_offset = 0;     /* left offest of TB in the FB ~ 1/2 of width difference */
+static uint32_t tb_top_offset = 0;      /* top of TB in the FB, pixel rows, see textgfx_set_origin() */
+static uint32_t tb_origin_x = TEXTGFX_ORIGIN_CENTRED;
+// Text rows off the page grid are written to two pages, glyph bits shifted 
+// down by 'tb_shift'. 'tb_lo_bits' / 'tb_hi_bits' are the rows of the upper /
+// lower page a text row covers.
+static uint8_t tb_shift = 0;
+static uint8_t tb_lo_bits = 0xFF;
+static uint8_t tb_hi_bits = 0x00;
+static uint8_t * tb_span_px = NULL;     /* one text line of glyph / mask columns, if tb_shift */
+static uint8_t * tb_span_mask = NULL;
+// Dirty cells, per text row the span [lo .. hi] of cells changed since the
+// last render. Only these are rendered into txt_framebuffer.
+#define TB_ROW_CLEAN 0xFF
+static uint8_t * row_dirty_lo = NULL;
+static uint8_t * row_dirty_hi = NULL;
 
-#define FTB_CTX_WMARK 0xFEEDFACE
 #define FTBIDX(x,y,w) ((y * w) + x)
+#define FTB_NIL       0xFF          /* end of a box list */
+#define FTB_POOL_MAX  254           /* boxes in a pool, slot + 1 fits the handle's octet */
+#define FTB_ALIGN     8             /* of the contexts in the arena */
 
 // Floating Text buffer handle ------------------------------------------------
 typedef struct ftbgfx_type {
-	uint32_t    wmark;                  /* watermark identifying this as a FTB context, see FTB_CTX_WMARK */
-    int32_t     ctx_id;                 /* unique ID for this context, when in-use. If unused then this is 0 */
+    uint32_t    seq;                    /* creation order, orders boxes of equal 'z' */
+	uint16_t    gen;                    /* generation of the slot, part of the handle: odd in use, even free */
+	uint8_t     next;                   /* next box in the free or visible list, FTB_NIL at the end */
 	uint8_t     tl_xpos;
 	uint8_t	    tl_ypos;
 	uint8_t	    tb_width;
@@ -380,76 +796,228 @@ typedef struct ftbgfx_type {
 	uint8_t     word_wrap;
 	uint8_t     currx;
 	uint8_t     curry;
-	uint8_t     do_render;  /* set true to get the underlying text layer to render this box to the screen. if 0 then it's hidden */
+	uint8_t     do_render;  /* set true to get the underlying text layer to render this box to the screen. if 0 then it's hidden. In the visible list when set */
 //	uint8_t     fb_width;	/* gfx framebuffer, number of horz. rows */
 //	uint8_t     fb_pages;   /* gfx framebuffer, number of vert. pages */
-	uint8_t     rsvd[2]; 
-	/* the text buffer (contains characters) */
+	uint8_t     attr;       /* TEXT_ATTR_* of chars put in */
+	uint8_t     drawn;      /* the box is in the text framebuffer, at drawn_x .. drawn_h */
+	uint8_t     drawn_x;
+	uint8_t     drawn_y;
+	uint8_t     drawn_w;
+	uint8_t     drawn_h;
+	/* the text buffer (contains characters), in the pool's char storage */
 	uint32_t    tbuf_len;
 	char *      tbuf;
+	uint8_t *   abuf;       /* attribute of each char, after the chars in the same allocation */
 	/* the destination framebuffer to render onto */
 //	uint32_t    fb_len;
 	uint8_t *   frame_buffer; /* copy of the local text framebuffer (clean this up later, no longer required) */
+	const gfxfont_t * font;
+	utf8_dec_t  utf8;
+	uint8_t     z;          /* stacking order, higher is drawn on top */
+	txt_canvas_t tile;      /* the box rasterized, top left at (0,0), see ftb_render() */
+	uint8_t     tile_ok;    /* tile shows the chars, cleared when they change */
 } ftbgfx_t;
 typedef ftbgfx_t * ftbgfx_p;
 
-// Fixed table of FTB contexts
-static ftbgfx_t ftbObjList[FTB_COUNT] = {0};
-
-// ID generator
-static int32_t ftbIDGen = 0;  /* pre-increment */
+// Pool of FTB contexts, carved from the arena given to ftbgfx_init_arena():
+// 'ftb_pool_count' contexts, then as many blocks of 'ftb_pool_cells' chars and
+// their attributes, then as many tiles of 'ftb_pool_tile' pixel octets and
+// their mask. Unused contexts are linked in the free list, shown boxes in the
+// visible list, bottom box first: by 'z', then by creation.
+static ftbgfx_p ftb_pool = NULL;
+static char *   ftb_pool_chars = NULL;
+static uint8_t * ftb_pool_tiles = NULL;
+static uint8_t  ftb_pool_count = 0;
+static uint16_t ftb_pool_cells = 0;
+static uint16_t ftb_pool_tile = 0;
+static uint8_t  ftb_free = FTB_NIL;
+static uint8_t  ftb_visible = FTB_NIL;
+
+// creation order of the boxes
+static uint32_t ftbSeqGen = 0;  /* pre-increment */
 
 // ----------------------------------------------------------------------------
 // --- Static Text Box API
 // ----------------------------------------------------------------------------
 
-// render current text buffer contents into the local text framebuffer.
-// Returns 1 on problems, 0 on success.
-static int textgfx_render(void) {
-    int rc = 1;
-    if (txt_framebuffer && text_buffer) {
-        uint32_t  i,j;
-        uint32_t  fptr = tb_left_offset;    // (STARTING) index for gfx framebuffer
-        uint32_t  page = (uint32_t)-1;      // gfx framebuffer page#, rolls over to 0 in the first loop iteration
-        const uint8_t * ftb = NULL;         // font buffer pointer, for the n cols of a character. points to leftmost col to start
-        char * tb = &(text_buffer[0]);      // shorter alias 
-        
-		// Delete the entire mask ? - test before adding code.
-
-        for ( i = 0 ; i < textBufLen ; i++ ) {
-            // for each character location in the text buffer ...
-            if ( (i % char_width) == 0 ) {
-                // at end of current line ...
-                // capture a text buffer line wrap, re-calculate index into the gfx frame buffer
-                page ++;
-                fptr = (page * fb_pix_cols) + tb_left_offset;
-            }
-            // render character, by colunms
-            ftb = &(font_5x7[(*tb) * FONT_W]); // 1st col. of the font char.
-            for ( j = 0 ; j < FONT_W ; j++ ) {
-                txt_framebuffer[fptr] = (*ftb) & 0x7F; // msb (bot of font) is blanked
-				// if current text character is non-zero (zero is taken as "no character")
-				// then put in place the background mask, otherwise do not mask as there
-				// is _NO_ text at this location. If you want to mask, use a whitespace (0x20)
-				// character.
-				if (*tb) {
-					txtmask_fb_start[fptr] = 0xff;  // set mask for this character location, by vert. segments
-				}
-				fptr++;
-                ftb++; // next col in the font character
+// text_buffer line shown on screen line 'y'
+static uint32_t ring_row(uint32_t y) {
+	return (y + tb_head) % char_height;
+}
+
+// screen line text_buffer line 'row' is rendered on
+static uint32_t row_line(uint32_t row) {
+	if (txt_scroll == SET_TEXTSCROLL_HW)
+		return row; // lines stay put, the panel scrolls
+	return (row + char_height - tb_head) % char_height;
+}
+
+// mark text cell (x,y) as changed, 'y' is a text_buffer line
+static void tb_mark_dirty(uint8_t x, uint8_t y) {
+	if (row_dirty_lo[y] == TB_ROW_CLEAN) {
+		row_dirty_lo[y] = row_dirty_hi[y] = x;
+	} else if (x < row_dirty_lo[y]) {
+		row_dirty_lo[y] = x;
+	} else if (x > row_dirty_hi[y]) {
+		row_dirty_hi[y] = x;
+	}
+	if (txt_prop) {
+		row_dirty_hi[y] = char_width - 1; // cells to the right move
+	}
+}
+
+// mark every text cell as changed, eg. after the text framebuffer was wiped
+static void tb_mark_all_dirty(void) {
+	if (row_dirty_lo) {
+		memset(row_dirty_lo, 0, char_height);
+		memset(row_dirty_hi, char_width - 1, char_height);
+	}
+}
+
+// pixel offset of cell 'x' on text row 'row', from the left of the text box
+static int row_px(uint32_t row, uint32_t x) {
+	const char * tb = &(text_buffer[row * char_width]);
+	int px = 0;
+	uint32_t i;
+	if (!txt_prop)
+		return x * font_cell_w(txt_font) * txt_scale;
+	for ( i = 0 ; i < x ; i++ )
+		px += font_advance(txt_font, (uint8_t)tb[i]);
+	return px * txt_scale;
+}
+
+// pixel rows of a static text line
+static int txt_line_h(void) {
+	return font_cell_h(txt_font) * txt_scale;
+}
+
+// render the dirty span of text row 'row' in a font other than gfxfont_5x7 or
+// scaled, 'tb' is its first cell. Proportional rows are blanked past the last cell.
+static void textgfx_render_font_row(uint32_t row, const char * tb) {
+	int y = tb_top_offset + (row_line(row) * txt_line_h());
+	int px0 = tb_left_offset + row_px(row, row_dirty_lo[row]);
+	int px = px0;
+	const uint8_t * ab = &(attr_buffer[(row * char_width) + row_dirty_lo[row]]);
+	uint32_t x;
+	for ( x = row_dirty_lo[row] ; x <= row_dirty_hi[row] && px < (int)fb_pix_cols ; x++ ) {
+		px += font_draw(&txt_canvas, txt_font, (uint8_t)*tb, px, y, fb_pix_cols, *tb != 0, txt_scale, (*tb) ? *ab : 0);
+		tb ++;
+		ab ++;
+	}
+	if (txt_prop) {
+		while (px < (int)fb_pix_cols)
+			px += font_draw(&txt_canvas, txt_font, 0, px, y, fb_pix_cols, 0, txt_scale, 0);
+	}
+	if (px > (int)fb_pix_cols)
+		px = fb_pix_cols;
+	gfx_addDamage(px0, y, px - px0, txt_line_h());
+	row_dirty_lo[row] = row_dirty_hi[row] = TB_ROW_CLEAN;
+}
+
+// write 'n' columns of glyph 'g' and mask 'm' (both one page high) with 
+// their top row 'tb_shift' rows down page 'fptr' / fb_pix_cols, the rows 
+// under it go into the page below. Done once per dirty span, the glyphs 
+// are put side by side in 'tb_span_px' / 'tb_span_mask' first.
+static void tb_write_shifted(uint32_t fptr, const uint8_t * g, const uint8_t * m, uint32_t n) {
+	uint8_t * lo  = &(txt_framebuffer[fptr]);
+	uint8_t * hi  = lo + fb_pix_cols;
+	uint8_t * mlo = &(txtmask_fb_start[fptr]);
+	uint8_t * mhi = mlo + fb_pix_cols;
+	uint8_t keep_lo = (uint8_t)~tb_lo_bits;
+	uint8_t keep_hi = (uint8_t)~tb_hi_bits;
+	uint8_t dn = tb_shift;
+	uint8_t up = 8 - tb_shift;
+	uint32_t i;
+	for ( i = 0 ; i < n ; i++ ) {
+		lo[i]  = (lo[i] & keep_lo) | (uint8_t)(g[i] << dn);
+		hi[i]  = (hi[i] & keep_hi) | (uint8_t)(g[i] >> up);
+		mlo[i] = (mlo[i] & keep_lo) | (uint8_t)(m[i] << dn);
+		mhi[i] = (mhi[i] & keep_hi) | (uint8_t)(m[i] >> up);
+	}
+}
+
+// render the dirty cells of the text buffer into the local text framebuffer,
+// no display refresh. Returns 1 if a cell was rendered.
+static int textgfx_render_cells(void) {
+    uint32_t  row, x;
+    uint32_t  fptr, span;               // index for gfx framebuffer
+    uint8_t * fb;
+    uint8_t * msk;
+    uint8_t   tmp[GLYPH_CELL_LEN];
+    uint8_t   acell[GLYPH_CELL_LEN];
+    const uint8_t * ab;
+    char * tb;
+    int dirty = 0;
+
+    for ( row = 0 ; row < char_height ; row++ ) {
+        if (row_dirty_lo[row] == TB_ROW_CLEAN)
+            continue; // nothing changed on this line
+        tb = &(text_buffer[(row * char_width) + row_dirty_lo[row]]);
+        ab = &(attr_buffer[(row * char_width) + row_dirty_lo[row]]);
+        dirty = 1;
+        if (txt_font != &gfxfont_5x7 || txt_scale > 1) {
+            textgfx_render_font_row(row, tb);
+            continue;
+        }
+        fptr = (((tb_top_offset >> 3) + row_line(row)) * fb_pix_cols) + tb_left_offset + (row_dirty_lo[row] * FONT_5x7_WIDTH);
+        span = fptr;
+        fb  = txt_framebuffer;
+        msk = txtmask_fb_start;
+        if (tb_shift) {
+            fb  = tb_span_px;
+            msk = tb_span_mask;
+            fptr = 0;
+        }
+        for ( x = row_dirty_lo[row] ; x <= row_dirty_hi[row] ; x++ ) {
+            // render character, 5 font columns then the blank one (vert. spacing)
+            // if current text character is non-zero (zero is taken as "no character")
+            // then put in place the background mask, otherwise remove it as there
+            // is _NO_ text at this location. If you want to mask, use a whitespace (0x20)
+            // character. The blank column is also masked.
+            // Off the page grid the line is built in the span buffers, then shifted.
+            const uint8_t * g = glyph_cell((uint8_t)*tb, tmp) + 1;
+            if (*ab && *tb) {
+                g = attr_cell(g, *ab, acell, FONT_5x7_WIDTH);
             }
-            txt_framebuffer[fptr] = 0; // last col of the font is blank (vert. spacing)
-			if (*tb) {
-				txtmask_fb_start[fptr] = 0xff; // blank is also masked!
-			}
-			fptr++;
+            memcpy(&(fb[fptr]), g, FONT_5x7_WIDTH);
+            memset(&(msk[fptr]), (*tb) ? 0xff : 0x00, FONT_5x7_WIDTH);
+            fptr += FONT_5x7_WIDTH;
             tb ++; // next char in the text buffer
+            ab ++;
+        }
+        if (tb_shift) {
+            tb_write_shifted(span, tb_span_px, tb_span_mask, fptr);
         }
+        gfx_addDamage(tb_left_offset + (row_dirty_lo[row] * FONT_5x7_WIDTH), tb_top_offset + (row_line(row) * FONT_5x7_HEIGHT),
+            (row_dirty_hi[row] - row_dirty_lo[row] + 1) * FONT_5x7_WIDTH, FONT_5x7_HEIGHT);
+        row_dirty_lo[row] = row_dirty_hi[row] = TB_ROW_CLEAN;
+    }
+	if (dirty) {
+		GFX_STATS_LAYER_UPDATE(txt_layer_prio);
+	}
+	return dirty;
+}
 
+// render the dirty cells of the text buffer into the local text framebuffer.
+// The display is not refreshed if no cell changed and the start line stays,
+// with no damage the BSP would send a full frame.
+// Returns 1 on problems, 0 on success.
+static int textgfx_render(void) {
+    int rc = 1;
+    if (txt_framebuffer && text_buffer) {
+		int move = txt_scroll == SET_TEXTSCROLL_HW && hw_start_line != ((size_t)tb_head * (size_t)txt_line_h());
+		if (!textgfx_render_cells() && !move)
+			return 0; // nothing to send
         // update screen from changed framebuffer
 		// use the higher level BSP API to ensure all fb layers
 		// are properly merged before written to screen.
 		rc = gfx_displayRefresh();
+		if (move) {
+			// new bottom line is on the panel, now bring it into view
+			hw_start_line = (size_t)tb_head * (size_t)txt_line_h();
+			rc |= gfx_setDisplayStartLine(hw_start_line);
+		}
     }
     return rc;
 }
@@ -460,8 +1028,12 @@ static int tbuf_fill(char c) {
 		// fills all char locations so...
 		// delete text data already rendered into the local text framebuffer
 		gfxutil_fb_clear(txt_framebuffer, txt_framebuffer_len, fb_fastcopy_enabled);
+		gfx_addDamageFull();
 		// put 'c' into all character locations in txt buffer
         memset(text_buffer, (int)c, textBufLen);
+        memset(attr_buffer, (c) ? txt_attr : TEXT_ATTR_NONE, textBufLen);
+		tb_mark_all_dirty();
+		tb_head = 0; // rendered back from page 0, see textgfx_render() for the start line
 		if (txt_mode == REFRESH_ON_TEXT_CHANGE) {
 			rc = textgfx_render(); // returns 0 on success
 		} else {
@@ -486,19 +1058,42 @@ int textgfx_init(int mode, int wrap) {
         // usually 8 rows of pixels. As such pages are arranged
         // as vertically stacked row groupings in the screen
         // area.
-        if (disp_page_pix_height >= FONT_5x7_HEIGHT) {
+        // The text box starts at pixel row 'tb_top_offset' and column 'tb_origin_x', 
+        // or is centred horizontally.
+        size_t left = (tb_origin_x == TEXTGFX_ORIGIN_CENTRED) ? 0 : tb_origin_x;
+        if (disp_page_pix_height >= FONT_5x7_HEIGHT && 
+            (fb_pix_height - tb_top_offset) >= (size_t)txt_line_h() && left < fb_pix_cols) {
+            // proportional fonts get enough cells for a line of their narrowest glyph
+            int cell_w = ((txt_prop) ? font_min_advance(txt_font) : font_cell_w(txt_font)) * txt_scale;
+            size_t cells = (fb_pix_cols - left) / cell_w;
             txt_mode = (uint8_t)mode;
             txt_wrap = (uint8_t)wrap;
             curx = cury = 0;
-            char_width = (uint8_t)(fb_pix_cols / FONT_5x7_WIDTH);
-            char_height = (uint8_t)disp_page_pix_height;
+            char_width = (uint8_t)((cells < 0xFF) ? cells : 0xFE);
+            char_height = (uint8_t)((fb_pix_height - tb_top_offset) / txt_line_h());
             curx_max = char_width - 1;
             cury_max = char_height - 1;
+            sr_top = 0;
+            sr_bot = cury_max;
             fb_pix_cols = (uint32_t)fb_pix_cols;
-            tb_left_offset = (fb_pix_cols - (char_width * FONT_5x7_WIDTH)) / 2;
+            if (tb_origin_x != TEXTGFX_ORIGIN_CENTRED) {
+                tb_left_offset = left;
+            } else {
+                tb_left_offset = (txt_prop) ? 0 : (fb_pix_cols - (char_width * cell_w)) / 2;
+            }
+            tb_shift = (uint8_t)(tb_top_offset & 7);
+            tb_lo_bits = (uint8_t)(0xFF << tb_shift);
+            tb_hi_bits = (uint8_t)~tb_lo_bits;
+            if (tb_shift) {
+                tb_span_px = (uint8_t *)malloc(fb_pix_cols * 2);
+                tb_span_mask = (tb_span_px) ? tb_span_px + fb_pix_cols : NULL;
+            }
             textBufLen = (char_width * char_height);
             text_buffer = (char *)malloc(textBufLen);
-            if (text_buffer) {
+            attr_buffer = (uint8_t *)malloc(textBufLen);
+            row_dirty_lo = (uint8_t *)malloc(char_height);
+            row_dirty_hi = (uint8_t *)malloc(char_height);
+            if (text_buffer && attr_buffer && row_dirty_lo && row_dirty_hi && (tb_span_px || !tb_shift)) {
                 tbuf_clear(); // this now also deletes data in the text framebuffer
                 rc = 0;
             }
@@ -507,6 +1102,78 @@ int textgfx_init(int mode, int wrap) {
     return rc;
 }
 
+int textgfx_set_font(const gfxfont_t * font) {
+	int rc = 1;
+	if (!text_buffer && font_valid(font) && font_scale_ok(font, txt_scale)) {
+		txt_font = font;
+		txt_prop = (font->widths != NULL);
+		rc = 0;
+	}
+	return rc;
+}
+
+int textgfx_set_attr(int attr) {
+	int rc = 1;
+	if ((attr & ~TEXT_ATTR_ALL) == 0) {
+		txt_attr = (uint8_t)attr;
+		txt_has_blink |= (attr & TEXT_ATTR_BLINK) ? 1 : 0;
+		rc = 0;
+	}
+	return rc;
+}
+
+int textgfx_get_attr(void) {
+	return (int)txt_attr;
+}
+
+// true if all the glyphs of the ranges of 'cs' are in the charset, a text
+// cell (CHARSET_CELL + glyph) must not wrap into the ASCII cells
+static int charset_ranges_ok(const gfxcharset_t * cs) {
+	uint16_t i;
+	for ( i = 0 ; i < cs->range_count ; i++ ) {
+		if ((uint32_t)cs->ranges[i].glyph + cs->ranges[i].count > cs->glyph_count)
+			return 0;
+	}
+	return 1;
+}
+
+int textgfx_set_charset(const gfxcharset_t * cs) {
+	int i;
+	if (!txt_framebuffer || (cs && (!cs->data || !cs->ranges || !cs->glyph_count || 
+	    cs->glyph_count > GFXCHARSET_MAX_GLYPHS || !charset_ranges_ok(cs))))
+		return 1;
+	if (cs && !glyph_cache) {
+		glyph_cache = (glyph_slot_t *)malloc(TEXTGFX_GLYPH_CACHE_SLOTS * sizeof(glyph_slot_t));
+		if (!glyph_cache)
+			return 1;
+	}
+	for ( i = 0 ; glyph_cache && i < TEXTGFX_GLYPH_CACHE_SLOTS ; i++ )
+		glyph_cache[i].used = 0;
+	glyph_clock = 0;
+	txt_charset = cs;
+	tb_mark_all_dirty(); // cells 0x80 and up look different now
+	return 0;
+}
+
+int textgfx_set_scale(int scale) {
+	int rc = 1;
+	if (!text_buffer && font_scale_ok(txt_font, scale)) {
+		txt_scale = (uint8_t)scale;
+		rc = 0;
+	}
+	return rc;
+}
+
+int textgfx_set_origin(uint x, uint y) {
+	int rc = 1;
+	if (!text_buffer && y < fb_pix_height && (x < fb_pix_cols || x == TEXTGFX_ORIGIN_CENTRED)) {
+		tb_origin_x = x;
+		tb_top_offset = y;
+		rc = 0;
+	}
+	return rc;
+}
+
 int textgfx_get_width(void) {
     return (int)char_width;
 }
@@ -559,39 +1226,216 @@ int textgfx_set_text_wrap_mode(int wrap) {
 	return rc;
 }
 
+int textgfx_get_scroll_mode(void) {
+	return (int)txt_scroll;
+}
+
+// reverse buf[a .. b)
+static void tbuf_reverse(uint8_t * buf, size_t a, size_t b) {
+	uint8_t t;
+	while (a + 1 < b) {
+		b --;
+		t = buf[a];
+		buf[a] = buf[b];
+		buf[b] = t;
+		a ++;
+	}
+}
+
+int textgfx_set_scroll_mode(int scroll) {
+	int rc = 1;
+	if (text_buffer && scroll >= SET_TEXTSCROLL_OFF && scroll <= SET_TEXTSCROLL_HW) {
+		if (scroll == SET_TEXTSCROLL_HW && 
+		    ((size_t)(char_height * txt_line_h()) != fb_pix_height || gfx_setDisplayStartLine(hw_start_line))) {
+			return 1; // text must cover the whole panel and the driver must scroll
+		}
+		if (tb_head) {
+			// back to line 0 on top, rotate the ring in place
+			tbuf_reverse((uint8_t *)text_buffer, 0, tb_head * char_width);
+			tbuf_reverse((uint8_t *)text_buffer, tb_head * char_width, textBufLen);
+			tbuf_reverse((uint8_t *)text_buffer, 0, textBufLen);
+			tbuf_reverse(attr_buffer, 0, tb_head * char_width);
+			tbuf_reverse(attr_buffer, tb_head * char_width, textBufLen);
+			tbuf_reverse(attr_buffer, 0, textBufLen);
+			tb_head = 0;
+		}
+		txt_scroll = (uint8_t)scroll;
+		if (hw_start_line) {
+			hw_start_line = 0;
+			gfx_setDisplayStartLine(0);
+		}
+		tb_mark_all_dirty();
+		rc = 0;
+	}
+	return rc;
+}
+
 int textgfx_clear(void) {
 	curx = cury = 0;
     return tbuf_clear();
 }
 
+// copy text line 'from' over line 'to' (screen lines), or blank it if 'from'
+// is out of the text box. Only a line that changes is marked dirty.
+static void tbuf_copy_line(uint32_t from, uint32_t to) {
+	char * t = &(text_buffer[ring_row(to) * char_width]);
+	uint8_t * a = &(attr_buffer[ring_row(to) * char_width]);
+	if (from < char_height) {
+		const char * tf = &(text_buffer[ring_row(from) * char_width]);
+		const uint8_t * af = &(attr_buffer[ring_row(from) * char_width]);
+		if (memcmp(t, tf, char_width) == 0 && memcmp(a, af, char_width) == 0)
+			return;
+		memcpy(t, tf, char_width);
+		memcpy(a, af, char_width);
+	} else {
+		memset(t, 0, char_width);
+		memset(a, TEXT_ATTR_NONE, char_width);
+	}
+	tb_mark_dirty(0, ring_row(to));
+	row_dirty_hi[ring_row(to)] = char_width - 1;
+}
+
+// scroll lines sr_top .. sr_bot, 'up' moves the text up a line and blanks
+// the bottom line, else down with the top line blanked
+static void tbuf_scroll_region(int up) {
+	uint32_t y;
+	if (up) {
+		for ( y = sr_top ; y < sr_bot ; y++ )
+			tbuf_copy_line(y + 1, y);
+		tbuf_copy_line(char_height, sr_bot);
+	} else {
+		for ( y = sr_bot ; y > sr_top ; y-- )
+			tbuf_copy_line(y - 1, y);
+		tbuf_copy_line(char_height, sr_top);
+	}
+}
+
+// terminal mode, the top line leaves and is re-used, blank, for the bottom one
+static void tbuf_scroll(void) {
+	uint8_t row = tb_head;
+	if (sr_top != 0 || sr_bot != cury_max) {
+		tbuf_scroll_region(1); // part of the lines, these are moved
+		return;
+	}
+	tb_head = (tb_head + 1) % char_height;
+	memset(&(text_buffer[row * char_width]), 0, char_width);
+	memset(&(attr_buffer[row * char_width]), TEXT_ATTR_NONE, char_width);
+	if (txt_scroll == SET_TEXTSCROLL_HW) {
+		tb_mark_dirty(0, row);
+		row_dirty_hi[row] = char_width - 1;
+	} else {
+		tb_mark_all_dirty(); // every line moves up
+	}
+}
+
+// cursor to the start of the next line, scrolls at the bottom in terminal mode
+static void tbuf_newline(void) {
+    curx = 0;
+    if (txt_scroll != SET_TEXTSCROLL_OFF && (cury == sr_bot || (cury > sr_bot && sr_bot == cury_max))) {
+        cury = sr_bot;
+        tbuf_scroll();
+    } else if (txt_scroll != SET_TEXTSCROLL_OFF && cury >= cury_max) {
+        cury = cury_max; // under the scroll region, stays on the bottom line
+    } else if (cury < char_height) {
+        cury ++; // if this is eq to 'char_height' now, then cursor is out of the text box area.
+    }
+}
+
+int textgfx_set_scroll_region(uint top, uint bottom) {
+	int rc = 1;
+	if (text_buffer && top < bottom && bottom < char_height) {
+		sr_top = (uint8_t)top;
+		sr_bot = (uint8_t)bottom;
+		rc = 0;
+	}
+	return rc;
+}
+
+int textgfx_scroll(int up) {
+	int rc = 1;
+	if (text_buffer && txt_scroll != SET_TEXTSCROLL_OFF) {
+		if (up)
+			tbuf_scroll();
+		else
+			tbuf_scroll_region(0);
+		rc = (txt_mode == REFRESH_ON_TEXT_CHANGE) ? textgfx_flush() : 0;
+	}
+	return rc;
+}
+
+int textgfx_erase(uint y, uint x0, uint x1) {
+	int rc = 1;
+	if (text_buffer && y < char_height && x0 <= x1) {
+		uint32_t row = ring_row(y);
+		char * t = &(text_buffer[row * char_width]);
+		uint8_t * a = &(attr_buffer[row * char_width]);
+		uint32_t x;
+		if (x1 > char_width)
+			x1 = char_width;
+		for ( x = x0 ; x < x1 ; x++ ) {
+			if (t[x] || a[x] != TEXT_ATTR_NONE) {
+				t[x] = 0;
+				a[x] = TEXT_ATTR_NONE;
+				tb_mark_dirty(x, row);
+			}
+		}
+		rc = (txt_mode == REFRESH_ON_TEXT_CHANGE) ? textgfx_flush() : 0;
+	}
+	return rc;
+}
+
+// place one char in the text buffer and move the cursor, no rendering.
+// returns +1 for char placed or 0 if could not place.
+static int tbuf_place(char c) {
+    int rc;
+    if (c == '\n' || c == '\r') {
+        tbuf_newline();
+        rc = 1;
+    } else if (c == '\b' || c == 0x7F) {
+        if (curx) {
+            curx --; // backspace (not supporting wrapping back up to prev page (x=0) on wordwrap.. may change this)
+        }
+        rc = 1;
+    } else if (txt_prop && (curx < char_width) && (cury < char_height) &&
+               ((size_t)tb_left_offset + (size_t)row_px(ring_row(cury), curx) +
+                (size_t)(font_advance(txt_font, (uint8_t)c) * txt_scale)) > fb_pix_cols) {
+        // proportional font, no room left on this line
+        if (txt_wrap) {
+            tbuf_newline();
+            rc = tbuf_place(c);
+        } else {
+            rc = 0;
+        }
+    } else if ((curx < char_width) && (cury < char_height)) {
+        uint32_t row = ring_row(cury);
+        uint32_t i = row * char_width + curx;
+        if (text_buffer[i] != c || attr_buffer[i] != txt_attr) {
+            text_buffer[i] = c;
+            attr_buffer[i] = txt_attr;
+            tb_mark_dirty(curx, row);
+        }
+        curx ++;
+        if (curx >= char_width && txt_wrap) {
+            tbuf_newline();
+        } // if no text wrap then cursor x position can go out of the text box area here.
+        rc = 1;
+    } else {
+        rc = 0;
+    }
+    return rc;
+}
+
 // returns -1 on error, else +1 for char placed or 0 if could not place.
+// place one octet of (UTF-8) text, 1 if it was taken
+static int tbuf_put(char c) {
+    int code = utf8_cell(&txt_utf8, (uint8_t)c);
+    return (code < 0) ? 1 : tbuf_place((char)code);
+}
+
 int textgfx_putc(char c) {
     int rc = -1;
     if (text_buffer) {
-        if (c == '\n' || c == '\r') {
-            curx = 0;
-            if (cury < char_height) {
-                cury ++; // if this is eq to 'char_height' now, then cursor is out of the text box area.
-            }
-            rc = 1;
-        } else if (c == 0x127) {
-            if (curx) {
-                curx --; // backspace (not supporting wrapping back up to prev page (x=0) on wordwrap.. may change this)
-            }
-            rc = 1;
-        } else if ((curx < char_width) && (cury < char_height)) {
-            text_buffer[cury * char_width + curx] = c;
-            curx ++;
-            if (curx >= char_width && txt_wrap) {
-                curx = 0;
-                if (cury < char_height) {
-                    cury ++;
-                }
-            } // if no text wrap then cursor x position can go out of the text box area here.
-            rc = 1;
-        } else {
-            rc = 0;
-        }
+        rc = tbuf_put(c);
 		if ((rc > 0) && (txt_mode == REFRESH_ON_TEXT_CHANGE)) {
 			if (textgfx_render() < 0) {
 				rc = -1; // some error occured during rendering
@@ -632,6 +1476,165 @@ int textgfx_refresh(void) {
     return textgfx_render();
 }
 
+// true if a cell changed since the last render
+static int tbuf_is_dirty(void) {
+	uint8_t row;
+	for ( row = 0 ; row < char_height ; row++ ) {
+		if (row_dirty_lo[row] != TB_ROW_CLEAN)
+			return 1;
+	}
+	return 0;
+}
+
+int textgfx_write(const char * buf, size_t len) {
+	int rc = -1;
+	if (text_buffer && buf) {
+		int newline = 0;
+		rc = 0; // counter
+		while (len && tbuf_put(*buf) > 0) {
+			newline |= (*buf == '\n');
+			buf ++;
+			len --;
+			rc ++;
+		}
+		// line buffered, a completed line shows up
+		if (newline && (txt_mode == REFRESH_ON_TEXT_CHANGE)) {
+			if (textgfx_flush()) {
+				rc = -1;
+			}
+		}
+	}
+	return rc;
+}
+
+int textgfx_printf(const char * fmt, ...) {
+	char buf[TEXTGFX_PRINTF_MAX];
+	char * big;
+	va_list args, again;
+	int len, rc;
+	if (!text_buffer || !fmt)
+		return -1;
+	va_start(args, fmt);
+	va_copy(again, args);
+	len = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (len < (int)sizeof(buf)) {
+		va_end(again);
+		return (len < 0) ? -1 : textgfx_write(buf, len);
+	}
+	// longer than the stack buffer, format it again on the heap
+	big = (char *)malloc((size_t)len + 1);
+	rc = (big && vsnprintf(big, (size_t)len + 1, fmt, again) == len) ? textgfx_write(big, len) : -1;
+	va_end(again);
+	free(big);
+	return rc;
+}
+
+// Number fields ---------------------------------------------------------------
+// Digits are found by subtracting powers of ten, no division (slow on the
+// M0+) and no printf.
+static const uint32_t pow10_tab[10] = {
+	1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+};
+
+// 'v' with 'dp' decimals (v / 10^dp) right aligned in out[0 .. w-1], spaces
+// to the left, all '#' if it does not fit
+static void num_format(char * out, uint32_t w, int32_t v, uint32_t dp) {
+	char dig[10];
+	uint32_t u = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+	uint32_t first = 9 - dp;        /* first digit shown, one before the point */
+	uint32_t len, i;
+	for ( i = 0 ; i < 10 ; i++ ) {
+		char d = '0';
+		while (u >= pow10_tab[i]) {
+			u -= pow10_tab[i];
+			d ++;
+		}
+		dig[i] = d;
+		if (d != '0' && i < first)
+			first = i;
+	}
+	len = (10 - first) + ((dp) ? 1 : 0) + ((v < 0) ? 1 : 0);
+	if (len > w) {
+		memset(out, '#', w);
+		return;
+	}
+	memset(out, ' ', w - len);
+	out += w - len;
+	if (v < 0)
+		*out++ = '-';
+	for ( i = first ; i < 10 ; i++ ) {
+		if (dp && i == 10 - dp)
+			*out++ = '.';
+		*out++ = dig[i];
+	}
+}
+
+int textgfx_put_fixed(int32_t v, uint dp, uint width) {
+	char field[TEXTGFX_NUM_MAX];
+	int rc = -1;
+	if (text_buffer && width && width <= TEXTGFX_NUM_MAX && dp <= 9 &&
+	    cury < char_height && (curx + width) <= char_width) {
+		uint32_t row = ring_row(cury);
+		char * t = &(text_buffer[(row * char_width) + curx]);
+		uint8_t * a = &(attr_buffer[(row * char_width) + curx]);
+		uint32_t i;
+		num_format(field, width, v, dp);
+		rc = 0;
+		for ( i = 0 ; i < width ; i++ ) {
+			if (t[i] != field[i] || a[i] != txt_attr) {
+				t[i] = field[i];
+				a[i] = txt_attr;
+				tb_mark_dirty(curx + i, row);
+				rc ++;
+			}
+		}
+		curx += width;
+		if (curx >= char_width && txt_wrap) {
+			tbuf_newline();
+		}
+		if (rc && (txt_mode == REFRESH_ON_TEXT_CHANGE) && textgfx_render()) {
+			rc = -1;
+		}
+	}
+	return rc;
+}
+
+int textgfx_put_int(int32_t v, uint width) {
+	return textgfx_put_fixed(v, 0, width);
+}
+
+int textgfx_flush(void) {
+	int rc = 1;
+	if (text_buffer) {
+		rc = (tbuf_is_dirty()) ? textgfx_render() : 0;
+	}
+	return rc;
+}
+
+#if (TEXTGFX_STDIO_DRIVER == 1)
+static void textgfx_stdio_out_chars(const char * buf, int len) {
+	if (len > 0)
+		textgfx_write(buf, (size_t)len);
+}
+
+static void textgfx_stdio_out_flush(void) {
+	textgfx_flush();
+}
+
+static stdio_driver_t textgfx_stdio = {
+	.out_chars = textgfx_stdio_out_chars,
+	.out_flush = textgfx_stdio_out_flush,
+};
+
+int textgfx_stdio_enable(int enable) {
+	if (!text_buffer)
+		return 1;
+	stdio_set_driver_enabled(&textgfx_stdio, (enable) ? true : false);
+	return 0;
+}
+#endif
+
 
 // ----------------------------------------------------------------------------
 // --- Floating Text Box API
@@ -642,142 +1645,362 @@ int textgfx_refresh(void) {
 
 static uint8_t ftb_initialized = 0;
 
+// draw a text box in a font other than gfxfont_5x7 or scaled into its tile,
+// lines are blanked to the right edge of the box.
+static void ftb_draw_font(ftbgfx_p pftb) {
+	const gfxfont_t * font = pftb->font;
+	const txt_canvas_t * cv = &(pftb->tile);
+	int m = (pftb->bk_trans) ? FONT_MASK_GLYPH : FONT_MASK_CELL;
+	int scale = pftb->txt_scale;
+	int xlim = cv->cols;
+	char * ptb = &(pftb->tbuf[0]);
+	uint8_t * pab = &(pftb->abuf[0]);
+	int tx, ty, x, y, adv;
+	for ( ty = 0 ; ty < pftb->tb_height ; ty++ ) {
+		x = 0;
+		y = ty * font_cell_h(font) * scale;
+		for ( tx = 0 ; tx < pftb->tb_width ; tx++ ) {
+			if (x < xlim)
+				x += font_draw(cv, font, (uint8_t)*ptb, x, y, xlim, m, scale, (*ptb) ? *pab : 0);
+			ptb ++;
+			pab ++;
+		}
+		adv = 1;
+		while (x < xlim && adv > 0) {
+			adv = font_draw(cv, font, 0, x, y, xlim, m, scale, 0);
+			x += adv;
+		}
+	}
+}
+
+// (re)size the tile of box 'pftb' for 'font' in its slot's tile block,
+// returns 0 on success, 1 if the box drawn in 'font' does not fit the block
+static int ftb_tile_alloc(ftbgfx_p pftb, const gfxfont_t * font) {
+	int cols = pftb->tb_width * font_cell_w(font) * pftb->txt_scale;
+	int pages = pftb->tb_height * font->pages * pftb->txt_scale;
+	uint8_t * px;
+	if ((size_t)cols * pages > ftb_pool_tile)
+		return 1;
+	if (pftb->tile.px && cols == pftb->tile.cols && pages == pftb->tile.pages)
+		return 0;
+	px = ftb_pool_tiles + ((size_t)(pftb - ftb_pool) * ftb_pool_tile * 2); // pixels then mask
+	pftb->tile.px = px;
+	pftb->tile.mask = px + (cols * pages);
+	pftb->tile.cols = cols;
+	pftb->tile.pages = pages;
+	pftb->tile_ok = 0;
+	return 0;
+}
+
+// rasterize the chars of box 'pftb' into its tile. The mask of a transparent
+// box is its lit pixels, an opaque box masks all of it.
+static void ftb_raster(ftbgfx_p pftb) {
+	txt_canvas_t * cv = &(pftb->tile);
+	if (pftb->font != &gfxfont_5x7 || pftb->txt_scale > 1) {
+		ftb_draw_font(pftb); // other fonts or scaled, column by column
+	} else {
+		// page aligned cells, the 5 font columns then the blank one, as
+		// textgfx_render_cells() and font_draw()
+		char * ptb = &(pftb->tbuf[0]);
+		uint8_t * pab = &(pftb->abuf[0]);
+		uint8_t tmp[GLYPH_CELL_LEN];
+		uint8_t acell[GLYPH_CELL_LEN];
+		uint8_t * px;
+		int tx, ty;
+		for ( ty = 0 ; ty < pftb->tb_height ; ty++ ) {
+			px = cv->px + (ty * cv->cols);
+			for ( tx = 0 ; tx < pftb->tb_width ; tx++ ) {
+				const uint8_t * fcol = glyph_cell((uint8_t)*ptb, tmp) + 1;
+				if (*pab && *ptb) {
+					fcol = attr_cell(fcol, *pab, acell, FONT_5x7_WIDTH);
+				}
+				memcpy(px, fcol, FONT_5x7_WIDTH);
+				px += FONT_5x7_WIDTH;
+				ptb ++;
+				pab ++;
+			}
+			if (pftb->bk_trans) {
+				// the line just drawn is the mask
+				memcpy(cv->mask + (ty * cv->cols), cv->px + (ty * cv->cols), cv->cols);
+			}
+		}
+		if (!pftb->bk_trans) {
+			memset(cv->mask, 0xff, cv->cols * cv->pages); // opaque
+		}
+	}
+	pftb->tile_ok = 1;
+}
+
+// Draw a box into the text framebuffer. Its chars are rasterized into the 
+// box's tile only when they changed, drawing is then a blit of the tile 
+// (pixels and mask) shifted to the box position and clipped to the screen.
+// An opaque box is copied over what is there, a transparent one (tile pixels
+// within its mask) ORed into it.
 #define DLY_WRITE_FB  0
 #define DO_WRITE_FB   1
 static void ftb_render(ftbgfx_p pftb, int do_writeFB) {
-    if (pftb && pftb->do_render) {
-		uint8_t  FB_WIDTH = fb_pix_cols; // pixel framebuffer width, horz pixel count
-        uint8_t  n = pftb->tl_ypos - (pftb->tl_ypos & 0xF8);
-        uint8_t  fbc = pftb->tl_xpos;
-        uint32_t fbi = ((uint32_t)(pftb->tl_ypos >> 8) * FB_WIDTH) + pftb->tl_xpos;
-        uint32_t fbn = fbi + FB_WIDTH;
-		uint8_t * frame_buffer = pftb->frame_buffer; // local FTB buffer, not the text's frame buffer.
-		uint32_t FB_BUF_LEN = txt_framebuffer_len;
-
-        // n indicates the number of bits in the font col shifted down into the next page down in
-        // the framebuffer. If 0 then the FTB pages are perfectly aligned vertically with the 
-        // framebuffer [FB] pages.
-
-        // fbc indexes in the FB but it is constrained to the floating text buffers pixel column and
-        // cannot go outside of it. it is tracked to see if it leaves the FB max col index (FB_WIDTH-1) to
-        // stop rendering of the FTB when it goes outside of the text buffer viewplane.
-        
-        // fbi points (in FB linear array!) to the upper part of the font (or whole font col if 
-        // y-pos is mult of 8) while fbn points (in FB linear array) to the next col location below 
-        // that may accept some remaining part of the font (or nothing), depending on the value of 
-        // y (upper-left pix posn. of the text box pos) fbi,fbn range:{0 .. FB_BUF_LEN-1}
-
-        // upper and lower column bit masks.. where the font col will be added in the FB 
-        // upper and lower pages (fbi, fbn)
-		// (v2.1) these are also use for the text framebuffer's mask buffer.
-        uint8_t um = 0xff << n; // mask for upper page. '1' indicates a font bit location
-        uint8_t lm = 0xff >> (8-n); // mask for lower page, if needed.
-        
-        // Iterator parameters txt_x, txt_y, font_col(0..5) (1..5) represent the character, 0 is 
-        // always blank
-        uint8_t tx   = 0;
-        uint8_t ty   = 0;
-        uint8_t col  = 0;
-        
-        // Points to the first CHARACTER in the floating text buffer. 
-        // This is simply incremented as code iterates over each row in the floating text box
-        char * ptb = &(pftb->tbuf[0]); // W.R.T. Floating Text Buffer (char index)
-        
-        // Iteration is counted as per the size of the floating text box, in characters 
-        // within 6x8 pixel boxes. 
-        //
-        // Framebuffer parameters to be updated are: 
-        //      fbc (inc, reset)    the X in FB[X][Y] in terms of a col index within limits(0 .. 127)
-        //      fbp (inc)           the Y in FB[X][Y] in terms of Page# within limits (0..7)
-        //                          the font char being rendered may be wholly within fbp's 8 pixels
-        //                          or may be partially (up to 7 pix) shifted into fbp+1 (if within range)
-        //      fbi (inc)           column index into framebuffer, the 'raw' index. represents the main render page
-        //      fbn (inc)           column directly below fbi.. may exceed the index limit for FB.. check this!
-
-        for (ty = 0 ; ty < pftb->tb_height ; ty++) {
-            // for each text line in the text box...
-            
-            // start over at the left side of the text box again 
-            // (FB 'X' coord, not an index into the table)
-            fbc = pftb->tl_xpos; 
-            // re-calculate where the 2 column locations are in the linear FB space as the
-            // ftb page (text row) is incremented
-            fbi = (((pftb->tl_ypos >> 3) + ty) * FB_WIDTH) + pftb->tl_xpos;
-            fbn = fbi + FB_WIDTH;
-
-            for (tx = 0 ; tx < pftb->tb_width ; tx++) {
-                // for each charactor on this row of the text box...
-                
-                const uint8_t * fcol = &(font_5x7[(*ptb) * FONT_W]); // 1st row in the active font
-                
-                for (col = 0 ; col < FONT_5x7_WIDTH ; col++) {
-                    // is x-position physically within the confines of the frame buffer ?
-                    if (fbc < FB_WIDTH) {
-                        // for now, wipe the framebuffer pixels underneath the text box.. 
-                        // ignore 'transparent mode'
-                        frame_buffer[fbi] &= (uint8_t)~(um);
-						// update fb mask (upper mask bits)
-						// note: fb is twice the required length. 2nd half is the mask.
-						//       fb_txt_seglen is the fb text length, eg. 1024 octets
-						//       so it will point to the corresponding mask when added to
-						//       the fb txt portion index 'fbi'
-						frame_buffer[fb_txt_seglen + fbi] |= um;
-                        if (n > 0 && fbn < FB_BUF_LEN) { // pages aligned or outside of FB ?
-                            frame_buffer[fbn] &= (uint8_t)~(lm);
-							frame_buffer[fb_txt_seglen + fbn] |= lm;
-						}
-                        // transfer text font, col-by-col (5-valid cols)
-                        if (col > 0) {  // 1..5 are rendered from the font character columns. 0 is a blank row
-                            frame_buffer[fbi] |= ((*fcol & 0x7F) << n); // bot pixels blanked, row separator
-                            if (n > 0 && fbn < FB_BUF_LEN) // pages aligned or outside of FB ?
-                                frame_buffer[fbn] |= ((*fcol & 0x7F) >> (8-n));
-                            fcol ++; // next col in the font
-                        }
-                    }
-                    fbc ++; // framebuffer 'col' index position range (0..127)
-                    fbi ++; // physical location into framebuffer memory, current page
-                    fbn ++; // " " next page down
-                }
-                
-                ptb ++; // next char in the floating text box
-            }
-        }
+    if (pftb && pftb->do_render && pftb->tile.px) {
+		txt_canvas_t * cv = &(pftb->tile);
+		bool copy = !pftb->bk_trans;
+		if (!pftb->tile_ok) {
+			ftb_raster(pftb);
+		}
+		gfxutil_blit(cv->px, cv->cols, cv->pages, copy, pftb->tl_xpos, pftb->tl_ypos,
+			txt_framebuffer, fb_pix_cols, fb_page_count);
+		gfxutil_blit(cv->mask, cv->cols, cv->pages, copy, pftb->tl_xpos, pftb->tl_ypos,
+			txtmask_fb_start, fb_pix_cols, fb_page_count);
+		pftb->drawn = 1;
+		pftb->drawn_x = pftb->tl_xpos;
+		pftb->drawn_y = pftb->tl_ypos;
+		pftb->drawn_w = cv->cols;
+		pftb->drawn_h = cv->pages * 8;
+		gfx_addDamage(pftb->drawn_x, pftb->drawn_y, pftb->drawn_w, pftb->drawn_h);
+		GFX_STATS_LAYER_UPDATE(txt_layer_prio);
 		if (do_writeFB) {
         	// update screen from changed framebuffer
 			// use higher level call to pull in other fb layers
 			gfx_displayRefresh();
-        	//g_llGfxDrvr->refreshDisplay(frame_buffer);
 		}
     }
 }
 
-static void render_floating_txt_tables(void) {
-    int i;
-    for ( i = 0 ; i < FTB_COUNT ; i++ ) {
-        if (ftbObjList[i].ctx_id > 0) {
-			// note: each text box *could* be on a separate framebuffer, so for now I have to write FB to screen for every table update..
-            ftb_render(&(ftbObjList[i]),DO_WRITE_FB);
-        }
+// rasterize every shown box into the text framebuffer, bottom up, no
+// display refresh. Returns the # of boxes rendered.
+static int render_floating_txt_tables(void) {
+    int n = 0;
+    uint8_t i;
+    for ( i = ftb_visible ; i != FTB_NIL ; i = ftb_pool[i].next ) {
+        ftb_render(&(ftb_pool[i]), DLY_WRITE_FB);
+        n ++;
     }
+    return n;
+}
+
+// Partial redraw of the text layer ---------------------------------------------
+// A box that moved (or was hidden, deleted) leaves its old rectangle. Only that
+// rectangle is wiped and drawn again, bottom up: the static cells under it,
+// then the boxes over it.
+
+// pixel rectangle [x0 .. x1) x [y0 .. y1), empty if x0 >= x1
+typedef struct txt_rect_type {
+	int x0, y0, x1, y1;
+} txt_rect_t;
+
+// where boxes were hidden since the last repair, see ftb_hide()
+static txt_rect_t ftb_wipe = {0, 0, 0, 0};
+
+static int rect_overlap(const txt_rect_t * a, const txt_rect_t * b) {
+	return a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+// grow 'a' to also hold 'b' (bounding box)
+static void rect_grow(txt_rect_t * a, int x0, int y0, int x1, int y1) {
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	if (a->x0 >= a->x1) {
+		a->x0 = x0; a->y0 = y0; a->x1 = x1; a->y1 = y1;
+		return;
+	}
+	if (x0 < a->x0) a->x0 = x0;
+	if (y0 < a->y0) a->y0 = y0;
+	if (x1 > a->x1) a->x1 = x1;
+	if (y1 > a->y1) a->y1 = y1;
+}
+
+static void ftb_rect(ftbgfx_p pftb, txt_rect_t * r) {
+	r->x0 = pftb->tl_xpos;
+	r->y0 = pftb->tl_ypos;
+	r->x1 = r->x0 + (pftb->tb_width * font_cell_w(pftb->font) * pftb->txt_scale);
+	r->y1 = r->y0 + (pftb->tb_height * font_cell_h(pftb->font) * pftb->txt_scale);
+}
+
+// box drawn somewhere it is no longer shown, or no longer shown at all
+static int ftb_stale(ftbgfx_p pftb) {
+	txt_rect_t r;
+	if (!pftb->drawn)
+		return 0;
+	if (pftb->bk_trans && !pftb->tile_ok)
+		return 1; // new glyphs are ORed in, the old ones must go first
+	ftb_rect(pftb, &r);
+	return r.x0 != pftb->drawn_x || r.y0 != pftb->drawn_y ||
+	       (r.x1 - r.x0) != pftb->drawn_w || (r.y1 - r.y0) != pftb->drawn_h;
+}
+
+// wipe a (w x h) rectangle of the text framebuffer (text and mask) and add
+// it to 'r'
+static void txt_clear(txt_rect_t * r, int x, int y, int w, int h) {
+	gfxutil_fill_rect(txt_framebuffer, fb_pix_cols, fb_page_count, x, y, w, h, GFXUTIL_FILL_CLEAR);
+	gfxutil_fill_rect(txtmask_fb_start, fb_pix_cols, fb_page_count, x, y, w, h, GFXUTIL_FILL_CLEAR);
+	gfx_addDamage(x, y, w, h);
+	rect_grow(r, x, y, x + w, y + h);
+}
+
+// wipe the old rectangle of a stale box and add it to 'r'
+static void ftb_erase(ftbgfx_p pftb, txt_rect_t * r) {
+	txt_clear(r, pftb->drawn_x, pftb->drawn_y, pftb->drawn_w, pftb->drawn_h);
+	pftb->drawn = 0;
+}
+
+// mark the static cells under 'r' dirty, then grow 'r' over every dirty
+// cell, these are all rendered next
+static void tb_mark_rect_dirty(txt_rect_t * r) {
+	int lh, cw, y, x0, x1;
+	uint32_t line, row, c0, c1;
+	if (!text_buffer)
+		return;
+	lh = txt_line_h();
+	cw = font_cell_w(txt_font) * txt_scale;
+	x0 = r->x0 - (int)tb_left_offset;
+	x1 = r->x1 - (int)tb_left_offset;
+	for ( line = 0 ; line < char_height && r->x0 < r->x1 ; line++ ) {
+		y = tb_top_offset + (line * lh);
+		if (y >= r->y1 || (y + lh) <= r->y0 || x1 <= 0)
+			continue;
+		row = (txt_scroll == SET_TEXTSCROLL_HW) ? line : ring_row(line);
+		c0 = (txt_prop || x0 < 0) ? 0 : (uint32_t)(x0 / cw);
+		c1 = (txt_prop) ? (uint32_t)(char_width - 1) : (uint32_t)((x1 - 1) / cw);
+		if (c0 >= char_width)
+			continue;
+		if (c1 >= char_width)
+			c1 = char_width - 1;
+		tb_mark_dirty(c0, row);
+		tb_mark_dirty(c1, row);
+	}
+	for ( row = 0 ; row < char_height ; row++ ) {
+		if (row_dirty_lo[row] == TB_ROW_CLEAN)
+			continue;
+		y = tb_top_offset + (row_line(row) * lh);
+		rect_grow(r, tb_left_offset + row_px(row, row_dirty_lo[row]), y,
+			(txt_prop) ? (int)fb_pix_cols : (int)(tb_left_offset + row_px(row, row_dirty_hi[row] + 1)), y + lh);
+	}
+}
+
+// render, no display refresh, the boxes over 'r' bottom up. A box drawn may
+// cover the ones above it outside 'r', 'r' grows to take these too.
+static void ftb_render_over(txt_rect_t * r) {
+	txt_rect_t b;
+	uint8_t i;
+	for ( i = ftb_visible ; i != FTB_NIL ; i = ftb_pool[i].next ) {
+		ftb_rect(&(ftb_pool[i]), &b);
+		if (rect_overlap(r, &b)) {
+			ftb_render(&(ftb_pool[i]), DLY_WRITE_FB);
+			rect_grow(r, b.x0, b.y0, b.x1, b.y1);
+		}
+	}
+}
+
+// wipe the rectangles of hidden boxes and the old ones of stale boxes, then
+// re-render the static cells there (and those changed). 'r' is set to the area
+// the boxes must be drawn over.
+static void txt_repair(txt_rect_t * r) {
+	uint8_t i;
+	r->x0 = r->y0 = r->x1 = r->y1 = 0;
+	if (ftb_wipe.x0 < ftb_wipe.x1) {
+		txt_clear(r, ftb_wipe.x0, ftb_wipe.y0, ftb_wipe.x1 - ftb_wipe.x0, ftb_wipe.y1 - ftb_wipe.y0);
+		ftb_wipe.x0 = ftb_wipe.y0 = ftb_wipe.x1 = ftb_wipe.y1 = 0;
+	}
+	for ( i = ftb_visible ; i != FTB_NIL ; i = ftb_pool[i].next ) {
+		if (ftb_stale(&(ftb_pool[i])))
+			ftb_erase(&(ftb_pool[i]), r);
+	}
+	tb_mark_rect_dirty(r);
+	if (text_buffer)
+		textgfx_render_cells();
+}
+
+// Box lists -------------------------------------------------------------------
+
+// 'a' is drawn before (under) 'b'
+static int ftb_below(ftbgfx_p a, ftbgfx_p b) {
+	return a->z < b->z || (a->z == b->z && a->seq < b->seq);
+}
+
+// link box 'i' into the visible list, in drawing order
+static void ftb_link(uint8_t i) {
+	uint8_t * link = &ftb_visible;
+	while (*link != FTB_NIL && ftb_below(&(ftb_pool[*link]), &(ftb_pool[i])))
+		link = &(ftb_pool[*link].next);
+	ftb_pool[i].next = *link;
+	*link = i;
+}
+
+static void ftb_unlink(uint8_t i) {
+	uint8_t * link = &ftb_visible;
+	while (*link != FTB_NIL && *link != i)
+		link = &(ftb_pool[*link].next);
+	if (*link == i)
+		*link = ftb_pool[i].next;
+	ftb_pool[i].next = FTB_NIL;
+}
+
+// take box 'i' off the screen, its rectangle is wiped at the next repair
+static void ftb_hide(uint8_t i) {
+	ftbgfx_p pftb = &(ftb_pool[i]);
+	ftb_unlink(i);
+	pftb->do_render = 0;
+	if (pftb->drawn) {
+		rect_grow(&ftb_wipe, pftb->drawn_x, pftb->drawn_y, pftb->drawn_x + pftb->drawn_w, pftb->drawn_y + pftb->drawn_h);
+		pftb->drawn = 0;
+	}
 }
 
 static void ftbgfx_tb_clear(ftbgfx_p pftb) {
-    int i;
+    uint32_t i;
 	if (pftb && pftb->tbuf)
-    	for ( i = 0 ; i < pftb->tbuf_len ; i++ )
+    	for ( i = 0 ; i < pftb->tbuf_len ; i++ ) {
         	pftb->tbuf[i] = '\0';
+        	pftb->abuf[i] = TEXT_ATTR_NONE;
+		}
+	if (pftb)
+		pftb->tile_ok = 0;
+}
+
+// octets of one box in the arena: context, chars and attributes, tile and mask
+static size_t ftb_slot_size(uint16_t max_cells, uint16_t max_tile) {
+	return sizeof(ftbgfx_t) + ((size_t)max_cells * 2) + ((size_t)max_tile * 2);
+}
+
+size_t ftbgfx_arena_size(uint8_t count, uint16_t max_cells, uint16_t max_tile) {
+	return (FTB_ALIGN - 1) + ((size_t)count * ftb_slot_size(max_cells, max_tile));
+}
+
+int ftbgfx_init_arena(void * arena, size_t len, uint16_t max_cells, uint16_t max_tile) {
+	uintptr_t a = ((uintptr_t)arena + (FTB_ALIGN - 1)) & ~(uintptr_t)(FTB_ALIGN - 1);
+	size_t n;
+	int i;
+	if (!txt_framebuffer || ftb_initialized || !arena || !max_cells || !max_tile ||
+	    len < ftbgfx_arena_size(1, max_cells, max_tile))
+		return 1;
+	n = (len - (a - (uintptr_t)arena)) / ftb_slot_size(max_cells, max_tile);
+	if (n > FTB_POOL_MAX)
+		n = FTB_POOL_MAX;
+	ftb_pool = (ftbgfx_p)a;
+	ftb_pool_count = (uint8_t)n;
+	ftb_pool_cells = max_cells;
+	ftb_pool_tile = max_tile;
+	ftb_pool_chars = (char *)(ftb_pool + n);
+	ftb_pool_tiles = (uint8_t *)(ftb_pool_chars + (n * max_cells * 2));
+	memset(ftb_pool, 0, n * sizeof(ftbgfx_t));
+	for ( i = 0 ; i < (int)n ; i++ )
+		ftb_pool[i].next = (i + 1 < (int)n) ? (uint8_t)(i + 1) : FTB_NIL;
+	ftb_free = 0;
+	ftb_visible = FTB_NIL;
+	ftb_initialized = 1; // the pool is set up once
+	return 0;
 }
 
 int ftbgfx_init(void) {
 	int rc = 1;
 	if (txt_framebuffer) {
 		if (!ftb_initialized) {
-			int i;
-			for ( i=0 ; i < FTB_COUNT ; i++ ) {
-				ftbObjList[i].ctx_id = 0;
-				ftbObjList[i].do_render = 0;
+			size_t len = ftbgfx_arena_size(FTB_COUNT, FTB_CELLS_MAX, FTB_TILE_MAX);
+			void * arena = malloc(len);
+			if (!arena)
+				return 1;
+			if (ftbgfx_init_arena(arena, len, FTB_CELLS_MAX, FTB_TILE_MAX)) {
+				free(arena);
+				return 1;
 			}
-			ftb_initialized = 1; // only touch the tables once.
 		}
 		rc = 0; // subsequent calls are ignored.
 	}
@@ -809,68 +2032,111 @@ void * ftbgfx_new(uint8_t xpos, uint8_t ypos, uint8_t width, uint8_t hght, uint8
 	int pix_hght  = ftbgfx_get_max_pix_height();
 	
 	// check inputs for out of range
-	if (width * FONT_5x7_WIDTH + xpos >= pix_width )
+	if (scale == 0)
+		scale = FTB_SCALE_1; // taken before scaling was supported
+	if (!font_scale_ok(&gfxfont_5x7, scale))
 		return NULL;
-	if (hght * FONT_5x7_HEIGHT + ypos >= pix_hght )
+	if (width * FONT_5x7_WIDTH * scale + xpos >= pix_width )
+		return NULL;
+	if (hght * FONT_5x7_HEIGHT * scale + ypos >= pix_hght )
 		return NULL;
 	if (txt_framebuffer == NULL)
 		return NULL; // text layer needs to be initialized first!
 
-	for ( i=0 ; i < FTB_COUNT ; i++ ) {
-		if (ftbObjList[i].ctx_id == 0) {
-			phndl = &(ftbObjList[i]);
-			break;
-		}
+	if (ftb_free == FTB_NIL || ((uint32_t)width * hght) > ftb_pool_cells)
+		return NULL; // all in use, or more chars than a pool block holds
+	i = ftb_free;
+	phndl = &(ftb_pool[i]);
+	phndl->tb_width = width;
+	phndl->tb_height = hght;
+	phndl->txt_scale = scale;
+	if (ftb_tile_alloc(phndl, &gfxfont_5x7))
+		return NULL; // drawn, the box is bigger than a pool tile
+	ftb_free = phndl->next;
+	phndl->tbuf_len = (uint32_t)width * hght;
+	phndl->tbuf = ftb_pool_chars + ((size_t)i * ftb_pool_cells * 2); // chars then their attributes
+	phndl->abuf = (uint8_t *)(phndl->tbuf + phndl->tbuf_len);
+	ftbgfx_tb_clear(phndl);
+	phndl->seq = ++ftbSeqGen;
+	phndl->gen ++; // odd, in use
+	phndl->tl_xpos = xpos;
+	phndl->tl_ypos = ypos;
+	phndl->bk_trans = bkgnd_trans;
+	phndl->word_wrap = wwrap;
+	phndl->currx = 0;
+	phndl->curry = 0;
+	phndl->do_render = 1; // assume its visible when created
+	phndl->drawn = 0;
+	phndl->frame_buffer = txt_framebuffer;
+	phndl->font = &gfxfont_5x7;
+	phndl->utf8.need = 0;
+	phndl->attr = TEXT_ATTR_NONE;
+	phndl->z = 0;
+	ftb_link((uint8_t)i); // on top of the others with z 0
+    return (void *)(uintptr_t)(((uint32_t)phndl->gen << 8) | (uint32_t)(i + 1));
+}
+
+// The handle is (generation << 8) | (slot + 1). The generation of a slot is
+// bumped by ftbgfx_new() and ftbgfx_delete(), odd while the box is in use, so
+// a deleted box's handle no longer matches it.
+static ftbgfx_p validate_vptr(void * vptr) {
+	uintptr_t h = (uintptr_t)vptr;
+	uint32_t i = (uint32_t)(h & 0xFF) - 1;
+	if (i < ftb_pool_count && (h >> 8) == ftb_pool[i].gen && (ftb_pool[i].gen & 1))
+		return &(ftb_pool[i]);
+	return NULL;
+}
+
+int ftbgfx_set_font(void * ftbhnd, const gfxfont_t * font) {
+	int rc = 1;
+	ftbgfx_p phndl = validate_vptr(ftbhnd);
+	if (phndl && font_valid(font) && font_scale_ok(font, phndl->txt_scale) &&
+	    (phndl->tb_width * font_cell_w(font) * phndl->txt_scale + phndl->tl_xpos) < ftbgfx_get_max_pix_width() &&
+	    (phndl->tb_height * font_cell_h(font) * phndl->txt_scale + phndl->tl_ypos) < ftbgfx_get_max_pix_height() &&
+	    ftb_tile_alloc(phndl, font) == 0) {
+		phndl->font = font;
+		phndl->tile_ok = 0;
+		rc = 0;
 	}
-	if (phndl) {
-		phndl->tbuf_len = (uint32_t)width * hght;
-		phndl->tbuf = (char *)malloc(phndl->tbuf_len);
-		if (phndl->tbuf) {
-			ftbgfx_tb_clear(phndl);
-			phndl->wmark = FTB_CTX_WMARK;
-			phndl->ctx_id = ++ftbIDGen;
-			phndl->tl_xpos = xpos;
-			phndl->tl_ypos = ypos;
-			phndl->tb_width = width;
-			phndl->tb_height = hght;
-			phndl->bk_trans = bkgnd_trans;
-			phndl->txt_scale = 1; // scaling disabled for now
-			phndl->word_wrap = wwrap;
-			phndl->currx = 0;
-			phndl->curry = 0;
-			phndl->do_render = 1; // assume its visible when created
-			// phndl->fb_width = (uint8_t)g_llGfxDrvr->get_DispWidth();
-			// phndl->fb_pages = (uint8_t)g_llGfxDrvr->get_DispPageHeight();
-			// phndl->fb_len = (uint32_t)g_llGfxDrvr->get_FBSize();
-			phndl->frame_buffer = txt_framebuffer;
-		} else {
-			phndl->tbuf_len = 0;
-			phndl = NULL; // could not allocate mem for text buffer, failing.
-		}		
+	return rc;
+}
+
+int ftbgfx_set_attr(void * ftbhnd, int attr) {
+	ftbgfx_p phndl = validate_vptr(ftbhnd);
+	if (phndl && (attr & ~TEXT_ATTR_ALL) == 0) {
+		phndl->attr = (uint8_t)attr;
+		txt_has_blink |= (attr & TEXT_ATTR_BLINK) ? 1 : 0;
+		return 0;
 	}
-    return (void *)phndl;
+	return 1;
 }
 
-ftbgfx_p validate_vptr(void * vptr) {
-	ftbgfx_p phndl = (ftbgfx_p)vptr;
-	if (phndl && phndl->wmark == FTB_CTX_WMARK)
-		return phndl;
-	else
-		return NULL;
+int ftbgfx_set_z(void * ftbhnd, uint8_t z) {
+	ftbgfx_p phndl = validate_vptr(ftbhnd);
+	if (phndl) {
+		uint8_t i = (uint8_t)(phndl - ftb_pool);
+		if (phndl->do_render)
+			ftb_unlink(i);
+		phndl->z = z;
+		if (phndl->do_render)
+			ftb_link(i); // its new place in the drawing order
+	}
+    return (phndl) ? 0 : 1;
 }
 
 int ftbgfx_enable(void * ftbhnd) {
 	ftbgfx_p phndl = validate_vptr(ftbhnd);
-	if (phndl) {
+	if (phndl && !phndl->do_render) {
 		phndl->do_render = 1;
+		ftb_link((uint8_t)(phndl - ftb_pool));
 	}
     return (phndl) ? 0 : 1;
 }
 
 int ftbgfx_disable(void * ftbhnd) {
 	ftbgfx_p phndl = validate_vptr(ftbhnd);
-	if (phndl) {
-		phndl->do_render = 0;
+	if (phndl && phndl->do_render) {
+		ftb_hide((uint8_t)(phndl - ftb_pool));
 	}
     return (phndl) ? 0 : 1;
 }
@@ -878,13 +2144,16 @@ int ftbgfx_disable(void * ftbhnd) {
 int ftbgfx_delete(void * ftbhnd) {
     ftbgfx_p phndl = validate_vptr(ftbhnd);
     if (phndl) {
-        phndl->ctx_id = 0;
-		phndl->do_render = 0;
-		if (phndl->tbuf) {
-			free(phndl->tbuf);
-			phndl->tbuf = NULL;
-		}
+		uint8_t i = (uint8_t)(phndl - ftb_pool);
+		if (phndl->do_render)
+			ftb_hide(i);
+		phndl->gen ++; // even, the handle is no longer valid
+		phndl->tbuf = NULL;
+		phndl->abuf = NULL;
 		phndl->tbuf_len = 0;
+		phndl->tile.px = NULL;
+		phndl->next = ftb_free;
+		ftb_free = i; // the chars and tile blocks go with the slot
     }
     return (phndl) ? 0 : 1;
 }
@@ -938,22 +2207,37 @@ int ftbgfx_home(void * ftbhnd) {
 }
 
 
+static void ftb_bkspace(ftbgfx_p phndl) {
+	if (phndl->currx) {
+		if (phndl->currx < phndl->tb_width && phndl->curry < phndl->tb_height) {
+			// only clear chars within the textbox bounds
+			phndl->tbuf[FTBIDX(phndl->currx,phndl->curry,phndl->tb_width)] = '\0';
+			phndl->abuf[FTBIDX(phndl->currx,phndl->curry,phndl->tb_width)] = TEXT_ATTR_NONE;
+			phndl->tile_ok = 0;
+		}
+		// cursor could be outside of box.. that is ok.
+		phndl->currx --;
+	}
+}
+
 int ftbgfx_putc(void * ftbhnd, char c) {
 	int rc = -1;
     ftbgfx_p phndl = validate_vptr(ftbhnd);
     if (phndl) {
+		int code;
 		rc = 0;
-        if (c == 0x80) {
-            // backspace
-			if (phndl->currx) {
-				if (phndl->currx < phndl->tb_width && phndl->curry < phndl->tb_height) {
-					// only clear chars within the textbox bounds
-					phndl->tbuf[FTBIDX(phndl->currx,phndl->curry,phndl->tb_width)] = '\0';
-				}
-                // cursor could be outside of box.. that is ok.
-				phndl->currx --;
-			}
-		} else if (c == '\n' || c == '\r') {
+        if (c == '\b' || ((uint8_t)c == 0x80 && !txt_charset)) {
+            // backspace, 0x80 only without a charset (it is UTF-8 text then)
+			phndl->utf8.need = 0; // drops a part UTF-8 sequence
+			ftb_bkspace(phndl);
+			return rc;
+		}
+		code = utf8_cell(&(phndl->utf8), (uint8_t)c);
+		if (code < 0) {
+			return 1; // more of a UTF-8 sequence to come
+		}
+		c = (char)code;
+		if (c == '\n' || c == '\r') {
 			// newline-carriagereturn
             if (phndl->curry < phndl->tb_height) {
                 phndl->currx = 0;
@@ -969,6 +2253,8 @@ int ftbgfx_putc(void * ftbhnd, char c) {
 				}
 				if (phndl->currx < phndl->tb_width && phndl->curry < phndl->tb_height) {
 					phndl->tbuf[FTBIDX(phndl->currx,phndl->curry,phndl->tb_width)] = c;
+					phndl->abuf[FTBIDX(phndl->currx,phndl->curry,phndl->tb_width)] = phndl->attr;
+					phndl->tile_ok = 0;
 					// cursor may go outside of the box at which point only a cr-lf or backspace 
 					// or next char w/ wrap (or clear) can get back inside.
 					phndl->currx ++;
@@ -1002,36 +2288,111 @@ int ftbgfx_newline(void * ftbhnd) {
 }
 
 int ftbgfx_bkspace(void * ftbhnd) {
-	return ftbgfx_putc(ftbhnd, 0x80);
+    ftbgfx_p phndl = validate_vptr(ftbhnd);
+    if (phndl) {
+		phndl->utf8.need = 0; // no octet goes through the UTF-8 decoder
+		ftb_bkspace(phndl);
+    }
+    return (phndl) ? 0 : 1;
+}
+
+int ftbgfx_put_fixed(void * ftbhnd, int32_t v, uint dp, uint width) {
+	char field[TEXTGFX_NUM_MAX];
+	int rc = -1;
+	ftbgfx_p phndl = validate_vptr(ftbhnd);
+	if (phndl && width && width <= TEXTGFX_NUM_MAX && dp <= 9 &&
+	    phndl->curry < phndl->tb_height && (phndl->currx + width) <= phndl->tb_width) {
+		uint32_t idx = FTBIDX(phndl->currx, phndl->curry, phndl->tb_width);
+		uint32_t i;
+		num_format(field, width, v, dp);
+		rc = 0;
+		for ( i = 0 ; i < width ; i++ ) {
+			if (phndl->tbuf[idx + i] != field[i] || phndl->abuf[idx + i] != phndl->attr) {
+				phndl->tbuf[idx + i] = field[i];
+				phndl->abuf[idx + i] = phndl->attr;
+				phndl->tile_ok = 0;
+				rc ++;
+			}
+		}
+		phndl->currx += width;
+	}
+	return rc;
+}
+
+int ftbgfx_put_int(void * ftbhnd, int32_t v, uint width) {
+	return ftbgfx_put_fixed(ftbhnd, v, 0, width);
 }
 
 int ftbgfx_refresh(void * ftbhnd) {
     ftbgfx_p phndl = validate_vptr(ftbhnd);
     if (phndl) {
-		// USE WITH CAUTION - OTHER FTBs ALREADY RENDERED WILL BE DELETED
-		// Update the text graphic framebuffer with the current contents
-		// of the static framebuffer.
-		gfxutil_fb_clear(txt_framebuffer, txt_framebuffer_len, fb_fastcopy_enabled);
-		textgfx_render(); 
-		ftb_render(phndl,DO_WRITE_FB); 
+		// Only the rectangles of moved boxes and this box are drawn again,
+		// the rest of the text framebuffer is left as it is.
+		txt_rect_t r, b;
+		txt_repair(&r);
+		if (phndl->do_render) {
+			ftb_rect(phndl, &b);
+			rect_grow(&r, b.x0, b.y0, b.x1, b.y1);
+		}
+		ftb_render_over(&r); // this box and the others on it, in their order
+		gfx_displayRefresh();
     }
     return (phndl) ? 0 : 1;
 }
 
 int ftbgfx_refresh_all(void) {
-	// Update the text graphic framebuffer with the current contents
-	// of the static framebuffer. This acts to ensure a moving FTB does not corrupt
-	// underlying static text already rendered...
-	// eg. this will not work:
-	//		update static txt --> render txt --> txt_framebuffer
-	//		move FTB --> render text ----------> txt_framebuffer
-	//		move FTB --> render text ----------> txt_framebuffer (!) FB now has the old text box still in it
-	gfxutil_fb_clear(txt_framebuffer, txt_framebuffer_len, fb_fastcopy_enabled);
-	textgfx_render(); 
+	// A moved FTB would leave its old rectangle in the txt_framebuffer, 
+	// txt_repair() wipes it and draws the static text under it again. 
+	// Then all boxes are drawn, bottom up, and sent in one refresh.
+	txt_rect_t r;
+	txt_repair(&r);
 	render_floating_txt_tables();
+	gfx_displayRefresh();
     return 0;
 }
 
+// does text box 'pftb' show a blinking char
+static int ftb_has_blink(ftbgfx_p pftb) {
+	uint32_t i;
+	for ( i = 0 ; i < pftb->tbuf_len ; i++ )
+		if (pftb->tbuf[i] && (pftb->abuf[i] & TEXT_ATTR_BLINK))
+			return 1;
+	return 0;
+}
 
-
-
+int textgfx_blink_tick(void) {
+	txt_rect_t r = {0, 0, 0, 0};
+	txt_rect_t b;
+	int blinking = 0;
+	uint32_t i;
+	uint8_t k;
+	if (!txt_framebuffer)
+		return 1;
+	if (!txt_has_blink)
+		return 0; // nothing ever blinked
+	blink_on = !blink_on;
+	for ( i = 0 ; text_buffer && i < textBufLen ; i++ ) {
+		if (text_buffer[i] && (attr_buffer[i] & TEXT_ATTR_BLINK)) {
+			tb_mark_dirty(i % char_width, i / char_width);
+			blinking = 1;
+		}
+	}
+	for ( k = ftb_visible ; k != FTB_NIL ; k = ftb_pool[k].next ) {
+		ftbgfx_p pftb = &(ftb_pool[k]);
+		if (ftb_has_blink(pftb)) {
+			pftb->tile_ok = 0; // the blink phase is in the tile
+			if (ftb_stale(pftb))
+				ftb_erase(pftb, &r);
+			ftb_rect(pftb, &b);
+			rect_grow(&r, b.x0, b.y0, b.x1, b.y1);
+			blinking = 1;
+		}
+	}
+	if (!blinking)
+		return 0;
+	tb_mark_rect_dirty(&r); // 'r' covers the dirty cells
+	if (text_buffer)
+		textgfx_render_cells();
+	ftb_render_over(&r); // boxes over blinking cells stay on top
+	return gfx_displayRefresh();
+}
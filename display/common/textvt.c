@@ -0,0 +1,274 @@
+/******************************************************************************
+ * textvt
+ *
+ * ANSI / VT100 terminal on the static text box (textgfx). See textvt.h for
+ * the sequences understood.
+ *
+ * Ver. 1.0
+ *
+ * The parser is a small state machine (ground, ESC, ESC intermediate, CSI)
+ * kept between writes, so a sequence may arrive one octet at a time. Text
+ * runs go to textgfx_write() and the cursor / erase / scroll calls of
+ * textgfx with the text box held in REFRESH_ON_DEMAND, the changed cells
+ * are rendered once at the end of textvt_write().
+ */
+
+#include <string.h>
+#include <textgfx.h>
+#include <textvt.h>
+
+#define VT_GROUND   0
+#define VT_ESC      1
+#define VT_CSI      2
+#define VT_ESC_INT  3   /* ESC + intermediates, up to the final octet */
+
+#define VT_PARAM_MAX    9999
+
+static uint8_t  vt_ready = 0;
+static uint8_t  vt_state = VT_GROUND;
+static uint8_t  vt_npar = 0;        /* index of the parameter being read */
+static uint8_t  vt_ignore = 0;      /* private / intermediate CSI, not ours */
+static uint16_t vt_par[TEXTVT_MAX_PARAMS];
+static uint8_t  vt_top = 0;         /* top line of the scroll region */
+static uint8_t  vt_save_x = 0;      /* ESC 7 / CSI s */
+static uint8_t  vt_save_y = 0;
+static uint8_t  vt_save_attr = TEXT_ATTR_NONE;
+
+// parameter 'i' of the CSI sequence, 'def' if missing or 0
+static int vt_param(int i, int def) {
+    return (i <= vt_npar && i < TEXTVT_MAX_PARAMS && vt_par[i]) ? vt_par[i] : def;
+}
+
+// cursor to (x,y), clipped to the text box
+static void vt_goto(int x, int y) {
+    int w = textgfx_get_width();
+    int h = textgfx_get_height();
+    if (x >= w)
+        x = w - 1;
+    if (y >= h)
+        y = h - 1;
+    textgfx_cursor((x < 0) ? 0 : x, (y < 0) ? 0 : y);
+}
+
+static void vt_set_region(int top, int bot) {
+    if (textgfx_set_scroll_region(top, bot) == 0)
+        vt_top = (uint8_t)top;
+}
+
+// one line down, scrolls at the bottom of the scroll region
+static void vt_index(void) {
+    int x = textgfx_get_cursor_posn_x();
+    textgfx_newline();
+    vt_goto(x, textgfx_get_cursor_posn_y());
+}
+
+// one line up, scrolls down at the top of the scroll region
+static void vt_reverse_index(void) {
+    int y = textgfx_get_cursor_posn_y();
+    if (y == vt_top)
+        textgfx_scroll(0);
+    else
+        vt_goto(textgfx_get_cursor_posn_x(), y - 1);
+}
+
+// erase in line, 'mode' 0: cursor to end, 1: start to cursor, 2: all
+static void vt_erase_line(int y, int x, int mode) {
+    int w = textgfx_get_width();
+    if (mode == 0)
+        textgfx_erase(y, x, w);
+    else if (mode == 1)
+        textgfx_erase(y, 0, x + 1);
+    else if (mode == 2)
+        textgfx_erase(y, 0, w);
+}
+
+static void vt_erase_screen(int mode) {
+    int x = textgfx_get_cursor_posn_x();
+    int y = textgfx_get_cursor_posn_y();
+    int h = textgfx_get_height();
+    int i;
+    if (mode > 2)
+        mode = 2; // 3, scrollback, is 2 here
+    vt_erase_line(y, x, mode);
+    for ( i = 0 ; i < h ; i++ ) {
+        if ((mode == 0 && i > y) || (mode == 1 && i < y) || (mode == 2 && i != y))
+            textgfx_erase(i, 0, textgfx_get_width());
+    }
+}
+
+static void vt_sgr(void) {
+    int attr = textgfx_get_attr();
+    int i;
+    for ( i = 0 ; i <= vt_npar && i < TEXTVT_MAX_PARAMS ; i++ ) {
+        switch (vt_par[i]) {
+            case 0:  attr = TEXT_ATTR_NONE;          break;
+            case 4:  attr |= TEXT_ATTR_UNDERLINE;    break;
+            case 5:  attr |= TEXT_ATTR_BLINK;        break;
+            case 7:  attr |= TEXT_ATTR_INVERSE;      break;
+            case 24: attr &= ~TEXT_ATTR_UNDERLINE;   break;
+            case 25: attr &= ~TEXT_ATTR_BLINK;       break;
+            case 27: attr &= ~TEXT_ATTR_INVERSE;     break;
+            default: break; // colours, bold ...
+        }
+    }
+    textgfx_set_attr(attr);
+}
+
+static void vt_save(void) {
+    vt_save_x = (uint8_t)textgfx_get_cursor_posn_x();
+    vt_save_y = (uint8_t)textgfx_get_cursor_posn_y();
+    vt_save_attr = (uint8_t)textgfx_get_attr();
+}
+
+static void vt_restore(void) {
+    vt_goto(vt_save_x, vt_save_y);
+    textgfx_set_attr(vt_save_attr);
+}
+
+// final octet 'f' of a CSI sequence
+static void vt_csi(char f) {
+    int x = textgfx_get_cursor_posn_x();
+    int y = textgfx_get_cursor_posn_y();
+    int n = vt_param(0, 1);
+    switch (f) {
+        case 'A': vt_goto(x, y - n);                            break;
+        case 'B': vt_goto(x, y + n);                            break;
+        case 'C': vt_goto(x + n, y);                            break;
+        case 'D': vt_goto(((x < textgfx_get_width()) ? x : textgfx_get_width()) - n, y); break;
+        case 'G': vt_goto(n - 1, y);                            break;
+        case 'd': vt_goto(x, n - 1);                            break;
+        case 'H':
+        case 'f': vt_goto(vt_param(1, 1) - 1, n - 1);           break;
+        case 'J': vt_erase_screen(vt_param(0, 0));              break;
+        case 'K': vt_erase_line(y, x, vt_param(0, 0));          break;
+        case 'S': while (n--) textgfx_scroll(1);                break;
+        case 'T': while (n--) textgfx_scroll(0);                break;
+        case 'm': vt_sgr();                                     break;
+        case 's': vt_save();                                    break;
+        case 'u': vt_restore();                                 break;
+        case 'r':
+            vt_set_region(n - 1, vt_param(1, textgfx_get_height()) - 1);
+            vt_goto(0, 0);
+            break;
+        default:  break;
+    }
+}
+
+static void vt_esc(char c) {
+    vt_state = VT_GROUND;
+    switch (c) {
+        case '[':
+            memset(vt_par, 0, sizeof(vt_par));
+            vt_npar = 0;
+            vt_ignore = 0;
+            vt_state = VT_CSI;
+            break;
+        case '7': vt_save();            break;
+        case '8': vt_restore();         break;
+        case 'D': vt_index();           break;
+        case 'E': textgfx_newline();    break;
+        case 'M': vt_reverse_index();   break;
+        case 'c': textvt_init();        break;
+        default:
+            if (c >= 0x20 && c <= 0x2F)
+                vt_state = VT_ESC_INT; // ESC ( B, ESC # 8 .. not ours
+            break;
+    }
+}
+
+// one octet after ESC and an intermediate, the final one ends it
+static void vt_esc_int_octet(char c) {
+    if (c < 0x20 || c > 0x2F)
+        vt_state = VT_GROUND;
+}
+
+// C0 control octets, in any state
+static void vt_ctrl(char c) {
+    int x = textgfx_get_cursor_posn_x();
+    switch (c) {
+        case '\r': vt_goto(0, textgfx_get_cursor_posn_y());     break;
+        case '\n':
+        case '\v':
+        case '\f': textgfx_newline();                           break;
+        case '\b': if (x) vt_goto(x - 1, textgfx_get_cursor_posn_y()); break;
+        case '\t': vt_goto((x + 8) & ~7, textgfx_get_cursor_posn_y()); break;
+        case 0x18: // CAN
+        case 0x1A: vt_state = VT_GROUND;                        break; // SUB
+        case 0x1B: vt_state = VT_ESC;                           break;
+        default:   break;
+    }
+}
+
+// one octet inside a CSI sequence
+static void vt_csi_octet(char c) {
+    if (c >= '0' && c <= '9') {
+        if (vt_npar < TEXTVT_MAX_PARAMS) {
+            uint32_t v = (vt_par[vt_npar] * 10) + (c - '0');
+            vt_par[vt_npar] = (uint16_t)((v > VT_PARAM_MAX) ? VT_PARAM_MAX : v);
+        }
+    } else if (c == ';') {
+        if (vt_npar < TEXTVT_MAX_PARAMS)
+            vt_npar ++;
+    } else if (c >= 0x20 && c <= 0x3F) {
+        vt_ignore = 1; // intermediates, private markers ('?', '>' ..)
+    } else if (c >= 0x40 && c <= 0x7E) {
+        vt_state = VT_GROUND;
+        if (!vt_ignore)
+            vt_csi(c);
+    } else {
+        vt_state = VT_GROUND; // DEL or 8 bit, not a sequence
+    }
+}
+
+int textvt_init(void) {
+    int h;
+    if (textgfx_set_refresh_mode(textgfx_get_refresh_mode()))
+        return 1; // text box not initialized
+    h = textgfx_get_height();
+    if (textgfx_get_scroll_mode() == SET_TEXTSCROLL_OFF)
+        textgfx_set_scroll_mode(SET_TEXTSCROLL_ON);
+    vt_top = 0;
+    textgfx_set_scroll_region(0, h - 1);
+    textgfx_set_attr(TEXT_ATTR_NONE);
+    vt_state = VT_GROUND;
+    vt_save_x = vt_save_y = 0;
+    vt_save_attr = TEXT_ATTR_NONE;
+    vt_ready = 1;
+    return textgfx_clear();
+}
+
+int textvt_write(const char * buf, size_t len) {
+    int mode = textgfx_get_refresh_mode();
+    size_t i = 0;
+    if (!vt_ready || !buf || textgfx_set_refresh_mode(REFRESH_ON_DEMAND))
+        return -1;
+    while (i < len) {
+        char c = buf[i];
+        if (vt_state == VT_GROUND && ((uint8_t)c >= 0x20 && c != 0x7F)) {
+            // a run of text, in one go
+            size_t n = 1;
+            while ((i + n) < len && (uint8_t)buf[i + n] >= 0x20 && buf[i + n] != 0x7F)
+                n ++;
+            textgfx_write(&buf[i], n); // what does not fit is dropped
+            i += n;
+            continue;
+        }
+        if ((uint8_t)c < 0x20)
+            vt_ctrl(c);
+        else if (vt_state == VT_ESC)
+            vt_esc(c);
+        else if (vt_state == VT_CSI)
+            vt_csi_octet(c);
+        else if (vt_state == VT_ESC_INT)
+            vt_esc_int_octet(c);
+        i ++;
+    }
+    textgfx_set_refresh_mode(mode);
+    if (mode == REFRESH_ON_TEXT_CHANGE && textgfx_flush())
+        return -1;
+    return (int)len;
+}
+
+int textvt_puts(const char * s) {
+    return (s) ? textvt_write(s, strlen(s)) : -1;
+}
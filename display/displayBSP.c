@@ -55,7 +55,8 @@ typedef struct driverProbe_type {
 gfxDriver_p_t llGfxDriverPriv = {
     NULL, NULL, NULL, NULL, NULL, NULL, NULL,
     NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-    NULL, NULL, NULL, NULL, NULL, NULL, NULL
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL
 };
 
 gfxDriver_p_p g_llGfxDrvrPriv = &llGfxDriverPriv;           // private device struct
@@ -99,6 +100,72 @@ void bsp_StopGfxDriver(void) {
     g_llGfxDrvrPriv->Close();
 }
 
+// Performance Counters -- see GFX_STATS_ENABLE in gfxDriverLow.h
+#if (GFX_STATS_ENABLE == 1)
+
+#ifndef GFX_STATS_CLOCK_US
+  #define GFX_STATS_CLOCK_US() time_us_32()
+#endif
+
+static gfx_stats_t gfx_stats = {0};
+static uint8_t     gfx_stats_layer_dirty[FB_LAYER_COUNT] = {0};
+
+static void stat_add(gfx_stat_t * s, uint32_t us) {
+    if (s->count == 0 || us < s->min_us)
+        s->min_us = us;
+    s->count ++;
+    s->total_us += us;
+    if (us > s->max_us)
+        s->max_us = us;
+}
+
+static void stat_hist_add(uint32_t us) {
+    uint32_t edge = GFX_STATS_HIST_BASE_US;
+    int bin = 0;
+    while ((bin < (GFX_STATS_HIST_BINS-1)) && (us >= edge)) {
+        edge <<= 1;
+        bin ++;
+    }
+    gfx_stats.hist[bin] ++;
+}
+
+// roll the per-frame layer change flags into the frame counters
+static void stat_layer_frames(void) {
+    int i;
+    for (i = 0 ; i < FB_LAYER_COUNT ; i++) {
+        if (gfx_stats_layer_dirty[i]) {
+            gfx_stats.layer_frames[i] ++;
+            gfx_stats_layer_dirty[i] = 0;
+        }
+    }
+}
+
+void gfx_stats_layer_update(uint8_t prio) {
+    if (prio < FB_LAYER_COUNT) {
+        gfx_stats.layer_updates[prio] ++;
+        gfx_stats_layer_dirty[prio] = 1;
+    }
+}
+
+void gfx_resetStats(void) {
+    memset(&gfx_stats, 0, sizeof(gfx_stats));
+    memset(gfx_stats_layer_dirty, 0, sizeof(gfx_stats_layer_dirty));
+}
+
+int gfx_getStats(gfx_stats_t * st) {
+    int rc = 1;
+    if (st) {
+        memcpy(st, &gfx_stats, sizeof(gfx_stats_t));
+        st->interval.avg_us = (st->interval.count) ? (uint32_t)(st->interval.total_us / st->interval.count) : 0;
+        st->compose.avg_us  = (st->compose.count)  ? (uint32_t)(st->compose.total_us  / st->compose.count)  : 0;
+        st->transmit.avg_us = (st->transmit.count) ? (uint32_t)(st->transmit.total_us / st->transmit.count) : 0;
+        rc = 0;
+    }
+    return rc;
+}
+
+#endif /* GFX_STATS_ENABLE */
+
 // Public API for graphics driver
 
 // show screen (turn on)
@@ -181,17 +248,138 @@ int gfx_setDisplayBrightness(int bri) {
     return g_llGfxDrvr->set_brightness(bri);
 }
 
+// show framebuffer row 'line' on the top of the screen (hardware scroll)
+int gfx_setDisplayStartLine(size_t line) {
+    if (!g_llGfxDrvr->set_startLine || line >= g_llGfxDrvr->get_DispHeight())
+        return 1;
+    return g_llGfxDrvr->set_startLine(line);
+}
+
+// Damaged area since the last composited frame, in driver columns and pages.
+static int     dmg_x0 = 0;
+static int     dmg_x1 = 0;      /* one past the last column */
+static int     dmg_p0 = 0;
+static int     dmg_p1 = 0;      /* one past the last page   */
+static uint8_t dmg_any = 0;
+static uint8_t dmg_full = 0;
+
+void gfx_addDamage(int x, int y, int w, int h) {
+    int x1 = x + w;
+    int p0, p1;
+    if (x < 0) x = 0;
+    if (y < 0) { h += y; y = 0; }
+    if (x1 > (int)g_llGfxDrvr->get_DispWidth()) x1 = (int)g_llGfxDrvr->get_DispWidth();
+    if (x >= x1 || h <= 0)
+        return;
+    p0 = y / 8;
+    p1 = (y + h + 7) / 8;
+    if (p1 > (int)g_llGfxDrvr->get_DispPageHeight()) p1 = (int)g_llGfxDrvr->get_DispPageHeight();
+    if (p0 >= p1)
+        return;
+    if (!dmg_any) {
+        dmg_x0 = x;  dmg_x1 = x1;
+        dmg_p0 = p0; dmg_p1 = p1;
+        dmg_any = 1;
+    } else {
+        if (x < dmg_x0)   dmg_x0 = x;
+        if (x1 > dmg_x1)  dmg_x1 = x1;
+        if (p0 < dmg_p0)  dmg_p0 = p0;
+        if (p1 > dmg_p1)  dmg_p1 = p1;
+    }
+}
+
+void gfx_addDamageFull(void) {
+    dmg_full = 1;
+}
+
+// send the composited driver framebuffer, only the damaged window if possible.
+// Returns the driver's return code, '*sent' is the # octets written.
+static int send_frame(size_t * sent) {
+    const uint8_t * fb = g_llGfxDrvr->get_drvrFrameBuffer();
+    int rc;
+    if (g_llGfxDrvr->refreshRegion && dmg_any && !dmg_full) {
+        size_t w = dmg_x1 - dmg_x0;
+        size_t pages = dmg_p1 - dmg_p0;
+        rc = g_llGfxDrvr->refreshRegion(fb, dmg_x0, w, dmg_p0, pages);
+        *sent = w * pages;
+    } else {
+        rc = g_llGfxDrvr->refreshDisplay(fb);
+        *sent = g_llGfxDrvr->get_FBSize();
+    }
+    dmg_any = 0;
+    dmg_full = 0;
+    return rc;
+}
+
+static int fb_compose(int * changed);
+
+// merge all fb layers onto the gfx driver fb, then send it. A layer written
+// through its sequence count (ISR writes do not report damage) forces a full
+// frame, as seen by the merge itself so a write landing after any earlier
+// check is not missed. '*t_sent' is the time the send started (stats).
+// Returns the driver's return code, 2 if a layer was torn.
+static int compose_send(size_t * sent, uint32_t * t_sent) {
+    int changed = 0;
+    int torn = (fb_compose(&changed) == 2);
+    int rc;
+    if (changed)
+        dmg_full = 1;
+#if (GFX_STATS_ENABLE == 1)
+    *t_sent = GFX_STATS_CLOCK_US();
+#else
+    (void)t_sent;
+#endif
+    rc = send_frame(sent);
+    return (rc == 0 && torn) ? 2 : rc;
+}
+
 // write driver's framebuffer to screen. see also gfx_refreshDisplay()
 // THIS IS THE ONLY CALL THAT MERGES ALL REGISTERED FRAMEBUFFER LAYERS
 int gfx_displayRefresh(void) {
-    gfx_fb_compositor(); // merge all fb layers onto the gfx driver fb first.
-    return g_llGfxDrvr->refreshDisplay( g_llGfxDrvr->get_drvrFrameBuffer() );
+    size_t sent = 0;
+    uint32_t t1 = 0;
+#if (GFX_STATS_ENABLE == 1)
+    int rc;
+    uint32_t t0, t2;
+    t0 = GFX_STATS_CLOCK_US();
+    rc = compose_send(&sent, &t1);
+    t2 = GFX_STATS_CLOCK_US();
+    if (gfx_stats.frames) {
+        stat_add(&gfx_stats.interval, t0 - gfx_stats.last_frame_us);
+    }
+    gfx_stats.frames ++;
+    gfx_stats.last_frame_us = t0;
+    stat_add(&gfx_stats.compose, t1 - t0);
+    stat_add(&gfx_stats.transmit, t2 - t1);
+    stat_hist_add(t2 - t0);
+    stat_layer_frames();
+    if (rc == 0 || rc == 2) {
+        gfx_stats.bytes_sent += sent;
+        if (sent < g_llGfxDrvr->get_FBSize())
+            gfx_stats.region_frames ++;
+    }
+    return rc;
+#else
+    return compose_send(&sent, &t1);
+#endif
 }
 
 // write frambuffer 'fb' to screen. 
 // pass driver's buffer in as 'fb' to write the internal buffer.
 int gfx_refreshDisplay(const uint8_t * fb) {
+#if (GFX_STATS_ENABLE == 1)
+    int rc;
+    uint32_t t0 = GFX_STATS_CLOCK_US();
+    rc = g_llGfxDrvr->refreshDisplay(fb);
+    stat_add(&gfx_stats.transmit, GFX_STATS_CLOCK_US() - t0);
+    gfx_stats.raw_frames ++;
+    if (rc == 0) {
+        gfx_stats.bytes_sent += g_llGfxDrvr->get_FBSize();
+    }
+    return rc;
+#else
     return g_llGfxDrvr->refreshDisplay(fb);
+#endif
 }
 
 // Graphic Framebuffer Layer Priority Control
@@ -224,25 +412,123 @@ int gfx_setFrameBufferLayerPrio(uint8_t * fb, uint8_t prio, uint8_t have_mask) {
     return rc;
 }
 
+// Layer sequence counters (seqlock). A writer that is not the thread running the
+// compositor (an ISR or the other core) brackets its layer writes with
+// gfx_layerWriteBegin()/End(). The count is odd while a write is under way.
+// Only one writer per layer, so no read-modify-write protection is needed.
+#ifndef GFX_COMPOSE_RETRIES
+  #define GFX_COMPOSE_RETRIES 3  /* extra compositor passes when a layer changed under it */
+#endif
+#define GFX_SEQ_BARRIER() __sync_synchronize()
+static volatile uint32_t fb_seq[FB_LAYER_COUNT] = {0};
+static uint32_t          fb_seq_seen[FB_LAYER_COUNT] = {0}; // count seen by the last compositor pass
+
+void gfx_layerWriteBegin(uint8_t prio) {
+    if (prio < FB_LAYER_COUNT) {
+        fb_seq[prio] ++;
+        GFX_SEQ_BARRIER(); // count is odd before any data is touched
+    }
+}
+
+void gfx_layerWriteEnd(uint8_t prio) {
+    if (prio < FB_LAYER_COUNT) {
+        GFX_SEQ_BARRIER(); // all data written before the count goes even again
+        fb_seq[prio] ++;
+    }
+}
+
+int gfx_layerPublish(uint8_t prio, size_t x, size_t page, size_t width, size_t pages, 
+    const uint8_t * pix, const uint8_t * mask) {
+    int rc = 1;
+    if (pix && (prio < FB_LAYER_COUNT) && fb_layers[prio] && width && pages) {
+        size_t fbw = g_llGfxDrvr->get_DispWidth();
+        size_t fbp = g_llGfxDrvr->get_DispPageHeight();
+        if ((x + width <= fbw) && (page + pages <= fbp)) {
+            size_t p;
+            gfx_layerWriteBegin(prio);
+            for (p = 0 ; p < pages ; p++) {
+                size_t idx = (page + p) * fbw + x;
+                memcpy(fb_layers[prio] + idx, pix + (p * width), width);
+                if (mask && fb_mask[prio]) {
+                    memcpy(fb_mask[prio] + idx, mask + (p * width), width);
+                }
+            }
+            gfx_layerWriteEnd(prio);
+            rc = 0;
+        }
+    }
+    return rc;
+}
+
+int gfx_layersChanged(void) {
+    int i;
+    for (i = 0 ; i < FB_LAYER_COUNT ; i++) {
+        if (fb_layers[i] && (fb_seq[i] != fb_seq_seen[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // call this method to combine fb layers into the driver's buffer
 // This now supports text fb on its own layer. Compositor MUST BE RUN
 // to get anything into the graphics framebuffer.
-int gfx_fb_compositor(void) {
+// A layer published to while it is being merged (sequence count odd or
+// changed) causes the whole composite to be re-done, up to GFX_COMPOSE_RETRIES
+// times. Writers are never held off.
+// '*changed' is set if a layer's count moved since the last clean pass, or 
+// the composite is torn: the merged frame has pixels no damage was added for.
+static int fb_compose(int * changed) {
     int rc = 1;
     if ( g_llGfxDrvrPriv ) {
         int i;
+        int pass = 0;
+        int torn;
+        uint32_t  seen[FB_LAYER_COUNT];
         size_t    fblen   = g_llGfxDrvr->get_FBSize();
         uint8_t * drvr_fb = g_llGfxDrvr->get_drvrFrameBuffer();
         // check for fast operation capability (should only need to invoke once)
         if (gfx_fb_can_optimize < 0) {
             gfx_fb_can_optimize = (fblen % sizeof(uint32_t)) ? 0 : 1;
         }
-        // clear driver's fb first to re-do layer compositing into it.
-        gfxutil_fb_clear(drvr_fb, fblen, gfx_fb_can_optimize);
+        do {
+            torn = 0;
+            // clear driver's fb first to re-do layer compositing into it.
+            gfxutil_fb_clear(drvr_fb, fblen, gfx_fb_can_optimize);
+            for (i = SET_FB_LAYER_BACKGROUND ; i < FB_LAYER_COUNT ; i++ ) {
+                if (fb_layers[i]) {
+                    uint32_t seq = fb_seq[i];
+                    GFX_SEQ_BARRIER();
+                    gfxutil_fb_merge(fb_layers[i], fb_mask[i], drvr_fb, fblen);
+                    GFX_SEQ_BARRIER();
+                    seen[i] = fb_seq[i];
+                    if ((seq & 1) || (seq != seen[i])) {
+                        torn = 1;
+                    }
+                }
+            }
+#if (GFX_STATS_ENABLE == 1)
+            if (torn) {
+                gfx_stats.compose_retries ++;
+            }
+#endif
+        } while (torn && (pass++ < GFX_COMPOSE_RETRIES));
+        *changed = torn;
         for (i = SET_FB_LAYER_BACKGROUND ; i < FB_LAYER_COUNT ; i++ ) {
-            if (fb_layers[i]) {
-                gfxutil_fb_merge(fb_layers[i], fb_mask[i], drvr_fb, fblen);
+            if (fb_layers[i] && (seen[i] != fb_seq_seen[i])) {
+                *changed = 1;
+                if (!torn) {
+                    // only a clean pass counts as seen, a torn layer stays changed
+                    fb_seq_seen[i] = seen[i];
+                }
             }
         }
+        rc = (torn) ? 2 : 0;
     }
-}
\ No newline at end of file
+    return rc;
+}
+
+int gfx_fb_compositor(void) {
+    int changed;
+    return fb_compose(&changed);
+}
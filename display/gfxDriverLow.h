@@ -28,6 +28,8 @@ typedef int (*fpset_DisplayBrightness)(int);
 typedef int (*fpdisplayOn)(void);
 typedef int (*fpdisplayOff)(void);
 typedef int (*fprefreshDisplay)(const uint8_t *);
+typedef int (*fprefreshRegion)(const uint8_t *, size_t, size_t, size_t, size_t);
+typedef int (*fpset_StartLine)(size_t);
 typedef int (*fpclearDisplay)(void);
 typedef const char * (*fpget_DriverName)(void);
 typedef uint8_t * (*fpget_FB)(void);
@@ -51,6 +53,8 @@ typedef struct gfxDriver_type {
     fpget_DispPageHeight    get_DispPageHeight;     // return display PAGE height
     fpget_FB                get_drvrFrameBuffer;    // return pointer to the drivers internal RAM framebuffer
     fpisReady               IsReady;                // return True if graphics driver is ready to use
+    fprefreshRegion         refreshRegion;          // (option) write a (col, width, page, pages) window of FB into display, NULL if not supported
+    fpset_StartLine         set_startLine;          // (option) show FB row 'line' on the top of the display (hardware scroll), NULL if not supported
 } gfxDriver_t;
 
 typedef gfxDriver_t * gfxDriver_p;
@@ -82,10 +86,14 @@ extern int gfx_setDisplayFlipY(int doFlip);        // control flipping screen on
 extern int gfx_setDisplayRot(int doRot);           // control rotating screen. (doRot = true) := rotate 180 deg.
 extern int gfx_setDisplayContrast(int con);        // set screen contrast. 0 = normal, range: {-10,0,+10} +ve is darker
 extern int gfx_setDisplayBrightness(int bri);      // set screen brightness. 0 = normal, range: {-10,0,+10} +ve is brighter
+extern int gfx_setDisplayStartLine(size_t line);   // show framebuffer row 'line' on the top of the screen, rows wrap around. 1 := not supported
 /* Update Screen Contents */
 
 // THIS IS THE ONLY CALL THAT MERGES ALL REGISTERED FRAMEBUFFER LAYERS
 // write driver's framebuffer to screen. see also gfx_refreshDisplay()
+// Returns 0 on success, the driver's error code, or 2 if a layer written
+// from an ISR was torn in every compositor pass (see gfx_fb_compositor()).
+// The frame was sent, the layer is still reported by gfx_layersChanged().
 extern int gfx_displayRefresh(void);
 
 // This DOES NOT Merge FB layers. Only the given layer is copied to screen.
@@ -109,4 +117,56 @@ extern int gfx_refreshDisplay(const uint8_t * fb);
 /* --- */
 #define FB_LAYER_COUNT (SET_FB_LAYER_FOREGROUND+1)
 
+/* --------------------------------------------------------
+ * Performance Counters (compile time option)
+ * --------------------------------------------------------
+ * Set GFX_STATS_ENABLE to 1 to have the BSP time each call to 
+ * gfx_displayRefresh() and gfx_refreshDisplay(). When left at 0
+ * none of the below (or the counting code in displayBSP.c) is
+ * compiled in.
+ * 
+ * Timestamps come from GFX_STATS_CLOCK_US(), which defaults to
+ * the pico time_us_32() free running microsecond counter. A host
+ * build can point this at its own clock.
+ */
+#ifndef GFX_STATS_ENABLE
+  #define GFX_STATS_ENABLE 0
+#endif
+
+#if (GFX_STATS_ENABLE == 1)
+
+#define GFX_STATS_HIST_BINS     8       /* frame time histogram, # of bins */
+#define GFX_STATS_HIST_BASE_US  250     /* upper edge of bin 0 [usec], each next bin doubles, last bin is open ended */
+
+// min/max/avg for one timed operation, all in usec.
+typedef struct gfx_stat_type {
+    uint32_t count;         /* # samples */
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t avg_us;        /* filled in by gfx_getStats() */
+    uint64_t total_us;
+} gfx_stat_t;
+
+typedef struct gfx_stats_type {
+    uint32_t   frames;              /* # composited frames, gfx_displayRefresh()      */
+    uint32_t   raw_frames;          /* # direct buffer writes, gfx_refreshDisplay()   */
+    uint32_t   last_frame_us;       /* timestamp, start of the last composited frame  */
+    gfx_stat_t interval;            /* time between composited frames                 */
+    gfx_stat_t compose;             /* time spent in the layer compositor             */
+    gfx_stat_t transmit;            /* time spent writing to the display (SPI, ...)   */
+    uint64_t   bytes_sent;          /* total octets written to the display            */
+    uint32_t   region_frames;       /* composited frames sent as a damaged region only */
+    uint32_t   compose_retries;     /* compositor passes spoiled by a layer publish   */
+    uint32_t   hist[GFX_STATS_HIST_BINS]; /* composited frame time (compose + transmit) */
+    uint32_t   layer_updates[FB_LAYER_COUNT]; /* # of draw calls reported per layer   */
+    uint32_t   layer_frames[FB_LAYER_COUNT];  /* # of frames in which the layer changed */
+} gfx_stats_t;
+
+// copy out the current counters. Returns 0 on success, 1 on a bad pointer.
+extern int gfx_getStats(gfx_stats_t * st);
+// zero all counters
+extern void gfx_resetStats(void);
+
+#endif /* GFX_STATS_ENABLE */
+
 #endif /* GFXDRIVERLOW_H */
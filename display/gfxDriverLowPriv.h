@@ -40,6 +40,8 @@ typedef struct gfxDriverPrivate_type {
     fpget_DispPageHeight    get_DispPageHeight;     // return display PAGE height
     fpget_FB                get_drvrFrameBuffer;    // return pointer to the drivers internal RAM framebuffer
     fpisReady               IsReady;                // return True if graphics driver is ready to use
+    fprefreshRegion         refreshRegion;          // (option) write a (col, width, page, pages) window of FB into display, NULL if not supported
+    fpset_StartLine         set_startLine;          // (option) show FB row 'line' on the top of the display (hardware scroll), NULL if not supported
     /* PRIVATE Methods */
     fpopen                  Open;
     fpinit                  Init;
@@ -110,6 +112,77 @@ int gfx_setFrameBufferLayerPrio(uint8_t * fb, uint8_t prio, uint8_t have_mask);
 // Returns:
 //  0 := SUCCESS
 //  1 := Failed
+//  2 := Composited, but a layer kept changing during all passes
+//       (see gfx_layerWriteBegin) so that layer may be torn. It is
+//       still reported by gfx_layersChanged(), the next frame will
+//       pick up the finished write.
 int gfx_fb_compositor(void);
 
+/* --------------------------------------------------------------------------------
+ * Layer updates from interrupt context (or the other core)
+ * --------------------------------------------------------------------------------
+ * Each layer has a sequence count. A writer running outside of the thread that 
+ * calls gfx_displayRefresh() wraps its layer writes in gfx_layerWriteBegin() and
+ * gfx_layerWriteEnd(). The compositor checks the count around each layer merge
+ * and re-does the composite if the layer changed under it, so a frame never
+ * shows half of an update. Neither side ever waits on the other.
+ * 
+ * Rules:
+ *  - one writer per layer. Give the ISR its own layer (eg. a small status glyph
+ *    on SET_FB_LAYER_2) rather than sharing the text or line layers.
+ *  - keep writes small, the compositor only retries GFX_COMPOSE_RETRIES times.
+ *  - do not call gfx_displayRefresh() from the ISR. The main loop can poll
+ *    gfx_layersChanged() and refresh when it returns true.
+ */
+
+// Mark the start and end of a write into layer 'prio' (any context).
+void gfx_layerWriteBegin(uint8_t prio);
+void gfx_layerWriteEnd(uint8_t prio);
+
+// Copy a small page aligned rectangle into layer 'prio' under its sequence
+// count. ISR safe, does not block.
+// Inputs:
+//  prio            layer, must be registered with gfx_setFrameBufferLayerPrio()
+//  x, page         top-left destination, pixel column and page index
+//  width, pages    rectangle size in pixel columns and pages
+//  pix             (width * pages) octets, page by page
+//  mask            optional (width * pages) mask octets, only used if the 
+//                  layer was registered with FB_HAS_MASK. NULL := leave mask.
+// Returns:
+//  0 := SUCCESS
+//  1 := Failed (layer not registered, rectangle off the screen)
+int gfx_layerPublish(uint8_t prio, size_t x, size_t page, size_t width, size_t pages, 
+    const uint8_t * pix, const uint8_t * mask);
+
+// Returns true if any layer has been written through gfx_layerWriteBegin/End
+// or gfx_layerPublish() since the last compositor pass.
+int gfx_layersChanged(void);
+
+/* --------------------------------------------------------------------------------
+ * Damage reporting
+ * --------------------------------------------------------------------------------
+ * Graphics APIs report the screen area they changed. gfx_displayRefresh() then
+ * only sends the bounding box of all damage since the last frame, if the driver
+ * has a refreshRegion() method. A full frame is sent if the driver cannot do
+ * regions, if gfx_addDamageFull() was called, if a layer was written through
+ * gfx_layerWriteBegin()/gfx_layerPublish() or if no damage was reported at all.
+ * 
+ * Every API drawing into a compositor layer must report its changes, otherwise
+ * they may not reach the screen until the next full frame.
+ */
+
+// Pixel rectangle (x, y, w, h) has changed, it is clipped to the screen.
+void gfx_addDamage(int x, int y, int w, int h);
+// Everything may have changed, send a full frame next.
+void gfx_addDamageFull(void);
+
+// Graphics APIs report a change to their layer with this. It only
+// feeds the performance counters and is empty if they are disabled.
+#if (GFX_STATS_ENABLE == 1)
+  extern void gfx_stats_layer_update(uint8_t prio);
+  #define GFX_STATS_LAYER_UPDATE(prio) gfx_stats_layer_update(prio)
+#else
+  #define GFX_STATS_LAYER_UPDATE(prio)
+#endif
+
 #endif /* GFXDRIVERLOWPRIV_H */
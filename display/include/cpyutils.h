@@ -71,35 +71,50 @@ typedef struct fbdata_type {
     uint8_t fb_width;  /* width, in pixels/text */
     uint8_t fb_height; /* height, in pixels/text */
     uint8_t rows_per_page; /* # row in each framebuffer page (grouping of rows) */
-    uint8_t resvd[3];  /* for alignment */
+    uint8_t cpy_width; /* (source) width of the area to copy, pixels/text. 0 := to the right edge */
+    uint8_t cpy_height;/* (source) height of the area to copy, pixels/text. 0 := to the bottom edge */
+    uint8_t resvd[1];  /* for alignment */
     uint32_t cpylen;   /* #bytes to copy out of the source fb */
     char *  ftb;        /* the framebuffer/textbuffer memory */
+    const uint8_t * font; /* (textbuffer source only) 5 column glyph table, (char * 5) indexed */
 } fbdata_t;
 
+// Character cell used when rendering a text buffer into a framebuffer.
+#define GFXUTIL_TXT_GLYPH_W     5   /* glyph columns in the font table */
+#define GFXUTIL_TXT_CELL_W      6   /* glyph + one blank spacing column */
+#define GFXUTIL_TXT_CELL_H      8   /* one page, bottom row is blank */
+
 /******************************************************************************
- * Copy one pixel framebuffer to another.
+ * Copy a rectangle of one pixel framebuffer into another.
  * 
  * Source (from) must configure:
  *      (fb_width, fb_height, rows_per_page)    
  *                  Geometry of the framebuffer
- *      cpylen      Bytelen of the framebuffer to copy (up to entire length 
- *                  of fb)
+ *      (tl_posn_x, tl_posn_y)
+ *                  pixel coords of the top-left of the area to copy
+ *      (cpy_width, cpy_height)
+ *                  size of the area to copy, 0 := up to the right/bottom edge
+ *      cpylen      Bytelen of the source framebuffer (0 := width * pages)
  *      ftb         framebuffer memory, array of page octets
  * Destination (to) must configure:
  *      (tl_posn_x, tl_posn_y)
  *                  pixel coords to start the copy at in the dest. buffer
  *      (fb_width, fb_height, rows_per_page)    
- *                  Geometry of the framebuffer. if smaller than src the 
- *                  copy will stop at the last byte in the dest. buffer.
+ *                  Geometry of the framebuffer. The copy is clipped on all
+ *                  edges to fit both the source and destination.
  *      ftb         framebuffer memory, array of page octets
  *
+ * Pixels of the destination inside the copied area are replaced, all others
+ * are left as they are. Page aligned copies are done as straight memcpy() per
+ * page, otherwise source pages are shifted and merged into the destination.
+ *
  * Notes:
- *  [1]     geometry:rows_per_page MUST match between 'from' and 'to' otherwise
+ *  [1]     geometry:rows_per_page MUST be 8 in both 'from' and 'to' otherwise
  *          call will return 0 (nothing copied).
  * Returns:
  *     -1           processing error
  *      0           nothing copied
- *      1+          # bytes copied from one fb to the other.
+ *      1+          # bytes written into the destination fb.
  */
 int gfxutil_fbfb_copy(fbdata_t * from, fbdata_t * to);
 
@@ -109,17 +124,27 @@ int gfxutil_fbfb_copy(fbdata_t * from, fbdata_t * to);
  * textbuffer source (from) must configure:
  *      (fb_width, fb_height)
  *                  Geometry of the text buffer, in characters.
- *      cpylen      Bytelen of the framebuffer to copy (up to entire length 
- *                  of fb)
+ *      (tl_posn_x, tl_posn_y)
+ *                  first character (column, row) to copy
+ *      (cpy_width, cpy_height)
+ *                  # of characters to copy, 0 := up to the right/bottom edge
  *      ftb         textbuffer memory, array of characters
+ *      font        glyph table, GFXUTIL_TXT_GLYPH_W columns per character
  * framebuffer destination (to) must configure:
  *      (tl_posn_x, tl_posn_y)
  *                  pixel coords to start the copy at in the dest. buffer
  *      (fb_width, fb_height, rows_per_page)    
- *                  Geometry of the framebuffer. if smaller than src the 
- *                  copy will stop at the last byte in the dest. buffer.
+ *                  Geometry of the framebuffer. Characters are clipped
+ *                  at the edges of the dest. buffer.
  *      ftb         framebuffer memory, array of page octets
  * 
+ * Each character is drawn as a GFXUTIL_TXT_CELL_W x GFXUTIL_TXT_CELL_H cell
+ * that replaces the pixels under it.
+ * 
+ * Returns:
+ *     -1           processing error
+ *      0           nothing copied
+ *      1+          # bytes written into the destination fb.
 */
 int gfxutil_tbfb_copy(fbdata_t * from, fbdata_t * to);
 
@@ -132,7 +157,8 @@ int gfxutil_tbfb_copy(fbdata_t * from, fbdata_t * to);
  * as whether to OR the bitmap into existing data or delete underlying data
  * in the destination framebuffer and overwrite that area.
  * 'from' must also give the top-left pixel coordinate to start in the destination
- * framebuffer.
+ * framebuffer. (at_x, at_y) are signed, the bitmap can be partially (or fully)
+ * off any edge of the destination and is clipped to what is visible.
  * 
  * buffer 'to' must have its width (pixels) and height (pages) such that the 
  * buffer octet array length is (width * pages) bytes.
@@ -146,14 +172,126 @@ int gfxutil_tbfb_copy(fbdata_t * from, fbdata_t * to);
  *     in the above example, the buffer array length would be (64 * 2) = 128 bytes.
  *     
  * Returns:
- *      0 := Success (EXIT_SUCCESS)
+ *      0 := Success (EXIT_SUCCESS), also when clipped away entirely.
  *      1 := failure, check params.
  * 
  */
 int gfxutil_blit(const uint8_t * from, size_t from_width, size_t from_pages, 
-    bool overwrite, size_t at_x, size_t at_y, uint8_t * to, size_t to_width, 
+    bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, 
     size_t to_pages);
 
 
+/******************************************************************************
+ * Fill, clear or invert a (w x h) pixel rectangle at (x,y) of a page format 
+ * framebuffer (width x pages). Clipped on all edges, (x,y) may be negative.
+ * 
+ * The row masks of the top and bottom pages are computed once, whole pages
+ * in between are written with memset().
+ * 
+ * Returns # octets written, 0 if clipped away, -1 on bad params.
+ */
+#define GFXUTIL_FILL_SET        0   /* set pixels (on)     */
+#define GFXUTIL_FILL_CLEAR      1   /* clear pixels (off)  */
+#define GFXUTIL_FILL_INVERT     2   /* toggle pixels       */
+
+int gfxutil_fill_rect(uint8_t * fb, size_t fb_width, size_t fb_pages, 
+    int x, int y, int w, int h, int mode);
+
+/******************************************************************************
+ * RLE bitmaps
+ * 
+ * Compressed form of a page format bitmap (same octets as for gfxutil_blit(),
+ * page by page, left to right) for bitmaps kept in flash. The stream is a
+ * sequence of packets, each starting with a control octet:
+ *      0x00 .. 0x7F    literal, the next (ctl + 1) octets are copied as is.
+ *      0x80 .. 0xFF    repeat, the next octet is repeated ((ctl & 0x7F) + 2)
+ *                      times.
+ * Runs and literals may cross from one page into the next.
+ * 
+ * gfxutil_rle_blit()
+ *      Same as gfxutil_blit() with an RLE source. Decodes straight into the
+ *      destination, no intermediate buffer. Clipped on all edges.
+ *      Returns 0 := ok, 1 := failure, check params.
+ * 
+ * gfxutil_rle_encode()
+ *      Compress 'len' octets of 'from' into 'to' (host tools, tests).
+ *      Worst case output is len + (len / 128) + 1 octets.
+ *      Returns # octets written into 'to' or -1 if 'to' is too small.
+ */
+#define GFXUTIL_RLE_REPEAT      0x80
+#define GFXUTIL_RLE_MIN_REPEAT  2
+#define GFXUTIL_RLE_MAX_REPEAT  (0x7F + GFXUTIL_RLE_MIN_REPEAT)
+#define GFXUTIL_RLE_MAX_LITERAL 128
+
+int gfxutil_rle_blit(const uint8_t * rle, size_t from_width, size_t from_pages, 
+    bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, 
+    size_t to_pages);
+int gfxutil_rle_encode(const uint8_t * from, size_t len, uint8_t * to, size_t to_len);
+
+/******************************************************************************
+ * Row-major <--> page format conversion
+ * 
+ * Row-major 1bpp images (XBM, PBM, most asset tools) hold 8 pixels across in
+ * each octet, rows padded out to whole octets: ((width + 7) / 8) octets per
+ * row. Page format holds 8 pixels down in each octet, LSB on top, and is
+ * (width * ((height + 7) / 8)) octets.
+ * 
+ * bit_order    GFXUTIL_BITS_LSB_FIRST : leftmost pixel in bit 0 (XBM)
+ *              GFXUTIL_BITS_MSB_FIRST : leftmost pixel in bit 7 (PBM)
+ * 
+ * gfxutil_rows_to_pages()   convert an image into page format.
+ * gfxutil_pages_to_rows()   convert a page format image (eg. a frame dump) 
+ *                           into row-major. Padding bits are cleared.
+ * 
+ * Conversion is done 8x8 pixels at a time as one 64 bit transpose.
+ * Returns 0 := ok, 1 := failure, check params.
+ */
+#define GFXUTIL_BITS_LSB_FIRST  0
+#define GFXUTIL_BITS_MSB_FIRST  1
+
+int gfxutil_rows_to_pages(const uint8_t * from, size_t width, size_t height, 
+    int bit_order, uint8_t * to);
+int gfxutil_pages_to_rows(const uint8_t * from, size_t width, size_t height, 
+    int bit_order, uint8_t * to);
+
+/******************************************************************************
+ * Sprite cache (opt-in)
+ * 
+ * A blit at a y position that is not page aligned has to shift every source
+ * byte and merge it into two destination pages. The cache keeps the shifted
+ * form of a bitmap, (pages + 1) high, for each vertical offset used so later
+ * blits of the same bitmap at the same offset are straight masked copies.
+ * 
+ * Entries are keyed on the bitmap pointer, so cached bitmaps must not change
+ * (ROM bitmaps) or gfxutil_sprcache_flush() must be called after they do.
+ * 
+ * gfxutil_sprcache_init()
+ *      slots       # of cached (bitmap, offset) entries, LRU replaced.
+ *      slot_bytes  size of each slot, must hold width * (pages + 1) of the
+ *                  largest bitmap to cache. Larger bitmaps bypass the cache.
+ *      Returns 0 := ok, 1 := error (already running, no memory).
+ * 
+ * gfxutil_blit_cached(), gfxutil_rle_blit_cached()
+ *      Same as gfxutil_blit() / gfxutil_rle_blit(). Bypasses the cache (plain
+ *      blit) if the cache is not running, the blit is page aligned or the 
+ *      bitmap is too large. A cached RLE bitmap is only decoded on a miss.
+ */
+typedef struct gfxutil_sprcache_stats_type {
+    uint32_t hits;      /* blits served from a cached slot             */
+    uint32_t misses;    /* blits that had to fill a slot first         */
+    uint32_t evictions; /* misses that replaced a used slot            */
+    uint32_t bypass;    /* blits done without the cache                */
+} gfxutil_sprcache_stats_t;
+
+int  gfxutil_sprcache_init(size_t slots, size_t slot_bytes);
+void gfxutil_sprcache_flush(void);
+int  gfxutil_sprcache_getStats(gfxutil_sprcache_stats_t * stats);
+void gfxutil_sprcache_resetStats(void);
+int  gfxutil_blit_cached(const uint8_t * from, size_t from_width, size_t from_pages, 
+    bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, 
+    size_t to_pages);
+int  gfxutil_rle_blit_cached(const uint8_t * rle, size_t from_width, size_t from_pages, 
+    bool overwrite, int at_x, int at_y, uint8_t * to, size_t to_width, 
+    size_t to_pages);
 
 #endif /* __CPYUTILS_H__ */
@@ -115,6 +115,13 @@ int lgfx_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t c);
 //      0 := OK, 1:= Error
 int lgfx_filled_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t c);
 
+// Clear the region from (x1,y1) to (x2,y2), both corners included.
+// Other graphics outside of it are left as they are.
+// Same as lgfx_filled_box(x1, y1, x2, y2, COLOUR_WHT).
+//  Returns,
+//      0 := OK, 1:= Error
+int lgfx_clear_box(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
+
 // Draw an Arc
 //  Inputs: (cx,cy)     centre of the arc
 //          r           radius (pixels)
@@ -46,6 +46,62 @@
 // ----------------------------------------------------------------------------
 int text_init(uint8_t layer_prio);
 
+// ----------------------------------------------------------------------------
+// --- Fonts
+// ----------------------------------------------------------------------------
+
+// Font descriptor. Glyphs are packed back to back in 'data', each
+// one page-major: 'pages' runs of 'width' octets, one octet is 8 
+// rows of one column (LSB on top), same as the framebuffer.
+// Proportional fonts give the width of each glyph in 'widths' and
+// where it starts in 'data' in 'offsets'. Fixed width fonts leave
+// both NULL, glyph 'c' is then at (c - first) * width * pages.
+// Fonts up to 4 pages (32 rows) high are supported.
+typedef struct gfxfont_type {
+    const uint8_t *  data;      /* packed glyphs                                    */
+    const uint8_t *  widths;    /* per glyph width [cols], NULL := fixed 'width'    */
+    const uint16_t * offsets;   /* per glyph start in 'data', NULL := fixed width   */
+    uint8_t first;              /* first char in the table                          */
+    uint8_t last;               /* last char in the table                           */
+    uint8_t width;              /* glyph width, widest glyph if proportional        */
+    uint8_t height;             /* pixel rows drawn {1 .. pages*8}, rest is blank   */
+    uint8_t pages;              /* octets per glyph column {1 .. 4}                 */
+    uint8_t spacing;            /* blank columns drawn after each glyph             */
+    uint8_t missing;            /* char drawn for those outside first .. last       */
+} gfxfont_t;
+
+extern const gfxfont_t gfxfont_5x7;     /* the default, fixed 5x7 in a 6x8 cell      */
+extern const gfxfont_t gfxfont_5x7p;    /* proportional 5x7, 0x20 .. 0x7E (font_5x7p.c) */
+
+// Extended character set, for text in gfxfont_5x7 beyond ASCII.
+// With a charset set text is taken as UTF-8. Code points are looked
+// up in 'ranges' and drawn from the charset's glyphs, unknown ones 
+// show as '?'. ASCII is drawn from the font as before.
+// A text cell holds 0x80 + glyph index, hence up to 
+// GFXCHARSET_MAX_GLYPHS glyphs.
+// Glyphs are 5 columns of 7 bits (one page, like gfxfont_5x7), 
+// bit packed back to back LSB first, glyph 'g' at bit (g * 35), 
+// plus one pad octet at the end of 'data'. Decoded glyphs are kept 
+// in a small RAM cache (TEXTGFX_GLYPH_CACHE_SLOTS, least recently 
+// used is replaced).
+#define GFXCHARSET_MAX_GLYPHS   127
+#define GFXCHARSET_COL_BITS     7
+
+typedef struct gfxcharset_range_type {
+    uint32_t first;             /* first code point                                 */
+    uint16_t count;             /* # code points, first .. first + count - 1        */
+    uint16_t glyph;             /* glyph of 'first', the others follow in order     */
+} gfxcharset_range_t;
+
+typedef struct gfxcharset_type {
+    const uint8_t *            data;        /* bit packed glyphs, see above         */
+    const gfxcharset_range_t * ranges;      /* sorted by 'first', no overlaps       */
+    uint16_t range_count;
+    uint8_t  glyph_count;                   /* {1 .. GFXCHARSET_MAX_GLYPHS}         */
+} gfxcharset_t;
+
+extern const gfxcharset_t gfxcharset_latin1;    /* accents, units, arrows (charset_latin1.c) */
+
 
 // ----------------------------------------------------------------------------
 // --- Static Text Box API
@@ -69,6 +125,38 @@ int text_init(uint8_t layer_prio);
 #define SET_TEXTWRAP_ON         1
 // (set in textgfx_init() -> 'wrap')
 
+// 'scroll'
+// What a newline on (or wrap off) the bottom line does.
+//   OFF            : cursor leaves the text box, further text is 
+//                    lost (default).
+//   ON             : terminal, all lines move up one and the bottom 
+//                    one is blank. No text is moved in memory, the 
+//                    text buffer is a ring of lines.
+//   HW             : as ON, the panel's display start line does the 
+//                    scroll so only the new line is written out. 
+//                    (!) This scrolls EVERY layer, use on a text only
+//                    screen. Needs driver support and text lines 
+//                    covering the whole panel height.
+#define SET_TEXTSCROLL_OFF      0
+#define SET_TEXTSCROLL_ON       1
+#define SET_TEXTSCROLL_HW       2
+// (set with textgfx_set_scroll_mode())
+
+// 'attr'
+// Per character attributes, OR'd together. Chars take the
+// attribute set when they are written.
+//   INVERSE        : light background, dark char. Spaces make
+//                    selection bars.
+//   UNDERLINE      : bottom row of the char cell set.
+//   BLINK          : char shown / blank on each 
+//                    textgfx_blink_tick().
+#define TEXT_ATTR_NONE          0x00
+#define TEXT_ATTR_INVERSE       0x01
+#define TEXT_ATTR_UNDERLINE     0x02
+#define TEXT_ATTR_BLINK         0x04
+#define TEXT_ATTR_ALL           0x07
+// (set with textgfx_set_attr(), ftbgfx_set_attr())
+
 // -----------------------------------------------------------
 // (!) Normally, a return of 0 is success and +1 is an error.
 //     Exceptions to this are documented in affected function
@@ -97,6 +185,52 @@ int text_init(uint8_t layer_prio);
 // ----------------------------------------------------------------------------
 int textgfx_init(int mode, int wrap);
 
+// Select the font of the static text box. Call after text_init()
+// and before textgfx_init(), which sizes the text box from it.
+// Proportional fonts wrap (or drop characters) at the right edge 
+// of the display, by pixels.
+// Returns 0 on success, 1 on a bad font or if already initialized.
+int textgfx_set_font(const gfxfont_t * font);
+
+// Attributes (TEXT_ATTR_*) of the chars written from now on.
+// Rewriting a char with other attributes re-renders it.
+// Returns 0 on success, 1 on unknown attribute bits.
+int textgfx_set_attr(int attr);
+int textgfx_get_attr(void);
+
+// Blink. Call periodically, eg. from a 500ms timer. Toggles the 
+// blink phase, re-renders only the static text cells with 
+// TEXT_ATTR_BLINK and the floating boxes holding such chars, then 
+// refreshes the display once. Does nothing if no blinking char 
+// was ever written.
+// Returns 0 on success, 1 if the text layer is not started.
+int textgfx_blink_tick(void);
+
+// Select the extended character set of all text (static and 
+// floating boxes) drawn in gfxfont_5x7, NULL for none (default).
+// Text written from then on is decoded as UTF-8, without a charset
+// chars 0x80 .. 0xFF draw the font's upper half as before.
+// Call after text_init(). 
+// Returns 0 on success, 1 on a bad charset (also a range with
+// glyphs past 'glyph_count') or no memory for the glyph cache.
+int textgfx_set_charset(const gfxcharset_t * cs);
+
+// Enlarge the static text 2, 3 or 4 times (FTB_SCALE_*), each font
+// pixel becomes 'scale' x 'scale' pixels. Font pages x scale must 
+// be 4 or less. Call before textgfx_init(), default is 1.
+// Returns 0 on success, 1 on a bad scale or if already initialized.
+int textgfx_set_scale(int scale);
+
+// Place the static text box with its top left corner at pixel 
+// (x,y), any row, not only on a page boundary. x may be 
+// TEXTGFX_ORIGIN_CENTRED (default) to centre the text lines.
+// The text box then takes what fits right of and under (x,y).
+// Call after text_init() and before textgfx_init(). Default is 
+// centred at the top, (TEXTGFX_ORIGIN_CENTRED, 0).
+// Returns 0 on success, 1 if off screen or already initialized.
+#define TEXTGFX_ORIGIN_CENTRED  0xFFFF
+int textgfx_set_origin(uint x, uint y);
+
 // Get the size parameters of the fixed text box.
 // If returning -1 then text box not initialized.
 int textgfx_get_width(void);       /* number of characters wide */
@@ -118,13 +252,33 @@ int textgfx_get_refresh_mode(void);     /* returns: REFRESH_ON_*      */
 int textgfx_get_text_wrap_mode(void);   /* returns: SET_TEXTWRAP_*    */
 int textgfx_set_refresh_mode(int mode);     /* returns: 0 := ok, 1:= not init'd */
 int textgfx_set_text_wrap_mode(int wrap);   /* returns: 0 := ok, 1:= not init'd */
+int textgfx_get_scroll_mode(void);          /* returns: SET_TEXTSCROLL_*  */
+int textgfx_set_scroll_mode(int scroll);    /* returns: 0 := ok, 1:= not init'd or not possible */
 
 // Clear the text screen
 // Returns 0 on success, 1 on some error.
 int textgfx_clear(void);
 
+// Terminal helpers (see textvt.h), lines are screen lines.
+// Scroll region: newlines on line 'bottom' scroll lines 'top' .. 
+// 'bottom' only, the lines above and below stay. Default is the 
+// whole text box. Needs a scroll mode other than OFF.
+// Returns 0 on success, 1 on a bad region or not init'd.
+int textgfx_set_scroll_region(uint top, uint bottom);
+// Scroll the region up (up != 0, bottom line blank) or down (top
+// line blank) one line. The cursor does not move. Needs a scroll
+// mode other than OFF.
+// Returns 0 on success, 1 if scroll is OFF or not init'd.
+int textgfx_scroll(int up);
+// Blank cells x0 .. x1-1 of line y (x1 is cut to the width), the
+// cursor does not move. Only cells that held something re-render.
+// Returns 0 on success, 1 on some error.
+int textgfx_erase(uint y, uint x0, uint x1);
+
 // Put characters into the text buffer. '\n' is inerpreted
 // as a newline and will reset x back to zero and increment y.
+// '\b' (0x08) and DEL (0x7F) move the cursor one char left, the
+// char there stays.
 // Overruns (if no wordwrap) will be lost and not counted in 
 // the parsed count.
 // Returns:
@@ -142,30 +296,113 @@ int textgfx_newline(void); // shortcut for textgfx_putc('\n');
 // Returns 0 on success, 1 on some error.
 int textgfx_refresh(void);
 
+// Buffered output. Characters go straight into the text buffer
+// cells (same rules as textgfx_putc()) and are rendered once, on
+// textgfx_flush(), or at the end of a write holding a '\n' when
+// in REFRESH_ON_TEXT_CHANGE mode (line buffered).
+// textgfx_printf() formats on the stack up to TEXTGFX_PRINTF_MAX-1
+// chars, longer output is formatted again in a malloc'd buffer (-1,
+// nothing written, if that fails).
+// Returns:
+//  -1    := error (not initialized or failed render)
+//   0+   := # characters (including \n) placed. Stops at the
+//           first char that could not be placed.
+// ---
+#ifndef TEXTGFX_PRINTF_MAX
+  #define TEXTGFX_PRINTF_MAX    64
+#endif
+int textgfx_write(const char * buf, size_t len);
+int textgfx_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Render the cells changed since the last render, if any.
+// Returns 0 on success, 1 on some error.
+int textgfx_flush(void);
+
+// Numbers without printf. 'v' goes right aligned into the 'width'
+// cells at the cursor, eg. textgfx_put_fixed(-1234, 2, 7) shows 
+// " -12.34" (v / 10^dp, 'dp' 0 .. 9). A number too long for the 
+// field shows as '#'s. Only cells that change are written and 
+// rendered, the cursor moves past the field.
+// The field must fit on the cursor line, width 1 .. TEXTGFX_NUM_MAX.
+// Returns:
+//  -1    := error (not initialized, field does not fit, failed render)
+//   0+   := # cells changed, 0 if the field already showed 'v'.
+// ---
+#ifndef TEXTGFX_NUM_MAX
+  #define TEXTGFX_NUM_MAX       12  /* "-2147483648" and a point */
+#endif
+int textgfx_put_int(int32_t v, uint width);
+int textgfx_put_fixed(int32_t v, uint dp, uint width);
+
+// stdio driver, so printf() and friends can target the text 
+// buffer (line buffered as above, fflush(stdout) flushes).
+// Needs TEXTGFX_STDIO_DRIVER=1 (default) and pico_stdio.
+// Returns 0 on success, 1 if the text buffer is not initialized.
+#ifndef TEXTGFX_STDIO_DRIVER
+  #define TEXTGFX_STDIO_DRIVER  1
+#endif
+#if (TEXTGFX_STDIO_DRIVER == 1)
+int textgfx_stdio_enable(int enable);
+#endif
+
 // ----------------------------------------------------------------------------
 // --- Floating Text Box API
 // --- Ver 2.0 : can use FTB, static text layer or both. FTB is no longer
 // ---           dependent on the static text system.
 // ----------------------------------------------------------------------------
 
-/* Number of concurrent active floating test boxes supported in the API */
+/* Number of concurrent active floating test boxes in the pool of ftbgfx_init() */
 #ifndef FTB_COUNT
   #define FTB_COUNT 4
 #endif
 
-/* future - Scaling factor */
+/* Chars (width x hght) a box of the ftbgfx_init() pool can hold */
+#ifndef FTB_CELLS_MAX
+  #define FTB_CELLS_MAX 64
+#endif
+
+/* Tile of a box of the ftbgfx_init() pool, in octets (columns x pages of
+   the box as drawn), default FTB_CELLS_MAX chars of gfxfont_5x7 at scale 1 */
+#ifndef FTB_TILE_MAX
+  #define FTB_TILE_MAX  (FTB_CELLS_MAX * 6)
+#endif
+
+/* Scaling factor, whole multiples of the font size.
+   API change: scaling used to be ignored, with FTB_SCALE_1_5 = 2 and
+   FTB_SCALE_2 = 3. The value is now the factor itself: FTB_SCALE_2 is 2,
+   and a literal 2 or 3 passed to ftbgfx_new() draws 2x or 3x. */
 #define FTB_SCALE_1     1       /* original scale, 1:1 */
-#define FTB_SCALE_1_5   2       /* expanded 1.5x       */
-#define FTB_SCALE_2     3       /* expanded 2x         */
+#define FTB_SCALE_2     2       /* expanded 2x         */
+#define FTB_SCALE_3     3       /* expanded 3x         */
+#define FTB_SCALE_4     4       /* expanded 4x         */
+#define FTB_SCALE_1_5   FTB_SCALE_1 /* deprecated, no 1.5x: drawn 1:1 */
 
 #define FTB_BKGRND_OPAQUE 0
 #define FTB_BKGRND_TRANSP 1
 #define FTB_TEXT_NOWRAP   0
 #define FTB_TEXT_WRAP     1
 
-// Setup for floating text boxes prior to their use.
+// Setup for floating text boxes prior to their use. The pool of
+// FTB_COUNT boxes of up to FTB_CELLS_MAX chars and FTB_TILE_MAX tile
+// octets is malloc'd, see ftbgfx_init_arena() to give it instead.
 int ftbgfx_init(void);
 
+// Setup for floating text boxes with the pool in the caller's 'arena'
+// of 'len' octets, in place of ftbgfx_init(). As many boxes as fit are
+// made (up to 254), each holding up to 'max_cells' chars and drawn in
+// a tile of up to 'max_tile' octets: columns x pages of the box with
+// its font and scale (a 16x4 box of gfxfont_5x7 at scale 1 is 96 x 4).
+// Boxes never malloc, the arena must stay valid for as long as boxes
+// are used.
+//  Returns,
+//      0 := OK, 1:= Error (text layer not initialized, pool already
+//           set up, or arena too small for one box)
+int ftbgfx_init_arena(void * arena, size_t len, uint16_t max_cells, uint16_t max_tile);
+
+// Size of an arena for 'count' boxes of up to 'max_cells' chars and
+// 'max_tile' tile octets.
+size_t ftbgfx_arena_size(uint8_t count, uint16_t max_cells, uint16_t max_tile);
+
 // Return the drawspace extents of the mounted display driver
 // Does not require an open floating text box instance.
 int ftbgfx_get_max_pix_width(void);
@@ -173,24 +410,52 @@ int ftbgfx_get_max_pix_height(void);
 int ftbgfx_get_max_textbox_width(void);
 int ftbgfx_get_max_textbox_height(void);
 
-// Create a new Floating Text Box, up to FTB_COUNT in total can be created.
+// Create a new Floating Text Box, as many as the pool holds (FTB_COUNT with
+// ftbgfx_init()) can be open at once.
 //  xpos,ypos   starting top-left box coordinates (can be changed later)
 //  width,hght  width and height of the text box, in characters.
 //  bkgnd_trans [0,1] if true then the text background is transparent and data
 //              already in the framebuffer will not be deleted in the text 
-//              boxes render area.
+//              boxes render area. Only the lit pixels of the chars are drawn
+//              and masked, lower layers (a graph ..) show between them.
 //              If false, then the FB area will be cleared first.
 // wwrap        [0,1]   0 := do not CR/LF at end of line. Stay on the same line.
 //                      1 := perform CR/LF at end of line, if not at the bottom line already.
 //                           cursor is set back to the left side on the next line down.
-// scale        (not yet supported) Font scaling.
+// scale        (FTB_SCALE_*) Font scaling, 1 .. 4. Each font pixel becomes
+//              'scale' x 'scale' pixels, the box size in characters stays.
+//              Font pages x scale must be 4 or less. 0 is taken as 1, as
+//              before scaling was supported.
 //
 // Returns:
 //  [void *] (handle) handle to the new text box. Required byh all other calls.
+//           A small integer, not a pointer: checked in O(1), calls with the
+//           handle of a deleted box fail. NULL if none is free or the box
+//           has more chars or a bigger tile than a pool box holds.
 // -----------------------------------------------------------------------------------------------
 void * ftbgfx_new(uint8_t xpos, uint8_t ypos, uint8_t width, uint8_t hght, 
     uint8_t bkgnd_trans, uint8_t wwrap, uint8_t scale);
 
+// Change the font of a text box. The box keeps its size in
+// characters, its pixel size follows from the font's widest glyph
+// and height, it must still fit on the display and in a pool tile.
+//  Returns,
+//      0 := OK, 1:= Error
+int ftbgfx_set_font(void * ftbhnd, const gfxfont_t * font);
+
+// Attributes (TEXT_ATTR_*) of the chars put in the box from now
+// on, see textgfx_set_attr() and textgfx_blink_tick().
+//  Returns,
+//      0 := OK, 1:= Error
+int ftbgfx_set_attr(void * ftbhnd, int attr);
+
+// Stacking order. Boxes with a higher 'z' are drawn over those
+// with a lower one, equal 'z' in the order the boxes were created.
+// Default is 0, so a new box goes on top of the others.
+//  Returns,
+//      0 := OK, 1:= Error
+int ftbgfx_set_z(void * ftbhnd, uint8_t z);
+
 // Set box as drawable (not hidden)
 //  Returns,
 //      0 := OK, 1:= Error
@@ -232,18 +497,21 @@ int ftbgfx_home(void * ftbhnd);
 // behavoir depends upon the word-wrap (wwrap) mode configured for the new FTB.
 //  ftbID   handle to the open text box.
 //  c       ASCII char. '\n' will cr/nl the cursor (next line down @ col 0) if possible.
-//          0x80 'DEL' will back cursor one character, towards left side.
+//          '\b' (0x08) backspace, clears the char left of the cursor and backs the
+//          cursor onto it. Without a charset 0x80 does the same (as before), with
+//          one 0x80 .. 0xFF are UTF-8 octets and '\b' is the only backspace. A
+//          backspace drops a UTF-8 sequence not yet complete.
 // Returns,
 //  [int]  0 nothing done (at right limit of text box with no wrap option?)
-//         1 character added. using '\n' or 0x80 will return zero!
+//         1 character added, or a UTF-8 octet taken. '\n' and backspace return zero!
 //        -1 error.
 int ftbgfx_putc(void * ftbhnd, char c);
 
 // put string at cursor, advancing the cursor as the string is added. End of line (text-box)
 // behavoir depends upon the word-wrap (wwrap) mode configured for the new FTB.
 //  ftbID   handle to the open text box.
-//  s       NULL terminated ASCII string (UTF-8). Can include '\n' for rc/nl and 0x80 'DEL' for
-//          backspace.
+//  s       NULL terminated ASCII string (UTF-8). Can include '\n' for rc/nl and '\b' for
+//          backspace, see ftbgfx_putc().
 // Returns,
 //  [int] 0+ len of string put into the text box.
 //        -1 error.
@@ -254,24 +522,32 @@ int ftbgfx_puts(void * ftbhnd, const char * s);
 //      0 := OK, 1:= Error
 int ftbgfx_newline(void * ftbhnd);
 
-// Shortcut to ftb_putc([DEL]);
+// Backspace, as ftbgfx_putc('\b'). Works the same with or without a
+// charset, nothing is passed to the UTF-8 decoder (a part sequence
+// is dropped).
 //  Returns,
 //      0 := OK, 1:= Error
 int ftbgfx_bkspace(void * ftbhnd);
 
+// Number fields, as textgfx_put_int() / textgfx_put_fixed(), into 
+// the floating box at its cursor. Call ftbgfx_refresh() to show 
+// them, it can be skipped when 0 cells changed.
+//  Returns,
+//     -1 := Error, 0+ := # cells changed
+int ftbgfx_put_int(void * ftbhnd, int32_t v, uint width);
+int ftbgfx_put_fixed(void * ftbhnd, int32_t v, uint dp, uint width);
+
 // Manually refresh the display with the current floating text buffer contents.
-// (!) THIS WILL WIPE OUT OTHER FTB INSTANCES!
-//     Use this only when one FTB is being used.
-//     The rendering process has to refresh the text framebuffer
-//     first from the static text. During this process, any previously
-//     updated FTBs will get wiped from the framebuffer.
-//     When using multiple FTBs, refresh them only using
-//     ftbgfx_refresh_all().
+// Boxes moved, hidden or deleted since they were drawn have their old 
+// rectangle wiped, the static text and other boxes under it are drawn
+// again. Boxes over this one are drawn after it. The rest of the text
+// framebuffer is left as it is.
 int ftbgfx_refresh(void * ftbhnd);
 
 // Refresh all open floating text boxes. Does not require a handle.
-// THis is safer to use as it ensure all active FTBs get rendered
-// into a fresh framebuffer, only with existing static text.
+// Old rectangles are repaired as for ftbgfx_refresh(), then every 
+// enabled box is drawn, bottom up (ftbgfx_set_z()), and the display
+// is refreshed once.
 int ftbgfx_refresh_all(void);
 
 #endif /* __TEXTGFX_H__ */
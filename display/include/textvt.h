@@ -0,0 +1,69 @@
+/******************************************************************************
+ * textvt
+ *
+ * ANSI / VT100 terminal on the static text box (textgfx). Mirrors a serial
+ * console: escape sequences move the cursor and erase instead of being
+ * drawn as text.
+ *
+ * Ver. 1.0
+ *
+ * Features:
+ *  - incremental parser, sequences may be split over any number of writes
+ *  - one render (at most) per textvt_write(), cells that did not change
+ *    are not rendered again
+ *  - subset: cursor moves, erase line / screen, SGR inverse, underline
+ *    and blink, scroll region
+ *
+ * Supported, others are consumed and ignored:
+ *  CR, LF (also returns the carriage, as onlcr), BS, TAB (8 columns)
+ *  ESC 7 / ESC 8   save / restore cursor
+ *  ESC D / ESC E   index, next line
+ *  ESC M           reverse index, scrolls down at the region top
+ *  ESC c           reset
+ *  CSI n A/B/C/D   cursor up / down / right / left
+ *  CSI r;c H / f   cursor position (1 based)
+ *  CSI c G, r d    column, row
+ *  CSI n J         erase screen: 0 to end, 1 to cursor, 2 all
+ *  CSI n K         erase line:   0 to end, 1 to cursor, 2 all
+ *  CSI t;b r       scroll region (DECSTBM), cursor home
+ *  CSI n S / T     scroll up / down
+ *  CSI s / u       save / restore cursor
+ *  CSI ... m       0 reset, 4 underline, 5 blink, 7 inverse, 24/25/27 off
+ *  ESC ( B ..      ESC, intermediates (0x20-0x2F) and a final octet, such
+ *                  as a charset select, are consumed and ignored
+ *
+ * Limitations:
+ *  - the static text box only, not floating text boxes
+ *  - the cursor wraps as soon as the last column is written (textgfx
+ *    wrap mode), not on the next char as a VT100 does
+ *  - scrolls need the text box in a scroll mode (textvt_init() sets
+ *    SET_TEXTSCROLL_ON unless already scrolling)
+ */
+
+#ifndef __TEXTVT_H__
+#define __TEXTVT_H__
+
+#include <stddef.h>
+#include "pico/types.h"
+
+// Numeric parameters kept per CSI sequence, further ones are dropped
+#ifndef TEXTVT_MAX_PARAMS
+  #define TEXTVT_MAX_PARAMS     4
+#endif
+
+// Start (or reset) the terminal on the static text box, which must be
+// initialized (textgfx_init()). Clears the text, homes the cursor and
+// resets the attributes and scroll region.
+// Returns 0 on success, 1 if the text box is not initialized.
+int textvt_init(void);
+
+// Feed 'len' octets of terminal output. Partial escape sequences are
+// kept for the next call. Text is rendered once, at the end, if the
+// text box is in REFRESH_ON_TEXT_CHANGE mode.
+// Returns:
+//  -1    := error (not initialized or failed render)
+//   0+   := # octets consumed, always 'len' on success.
+int textvt_write(const char * buf, size_t len);
+int textvt_puts(const char * s);
+
+#endif
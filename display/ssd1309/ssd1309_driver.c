@@ -205,6 +205,53 @@ int ssd1309drv_disp_frame(const uint8_t * octets) {
     return rc;
 }
 
+// Write a window of the framebuffer, 'width' columns from 'col' over 'pages'
+// pages from 'page'. The full-screen address window is restored afterwards
+// so ssd1309drv_disp_frame() can keep relying on it.
+int ssd1309drv_disp_region(const uint8_t * octets, size_t col, size_t width, size_t page, size_t pages) {
+    uint8_t win[6];
+    uint8_t full[6] = {C_SET_COLADDR, 0x00, SSD1309_DISP_COLS - 1, C_SET_PAADDR, 0, SSD1309_DISP_PAGES - 1};
+    size_t p;
+    int wcnt;
+    int rc = 0;
+    if (!octets || !width || !pages || (col + width) > SSD1309_DISP_COLS || (page + pages) > SSD1309_DISP_PAGES)
+        return 1;
+    win[0] = C_SET_COLADDR;
+    win[1] = (uint8_t)col;
+    win[2] = (uint8_t)(col + width - 1);
+    win[3] = C_SET_PAADDR;
+    win[4] = (uint8_t)page;
+    win[5] = (uint8_t)(page + pages - 1);
+    set_disp_dc(SET_DISP_STATE_CMD);
+    wcnt = spi_write_blocking(g_gfxdata.spichan, win, sizeof(win));
+    if (wcnt != sizeof(win))
+        return 1;
+    set_disp_dc(SET_DISP_STATE_DATA);
+    for (p = page ; p < (page + pages) ; p++) {
+        wcnt = spi_write_blocking(g_gfxdata.spichan, octets + (p * SSD1309_DISP_COLS) + col, width);
+        if (wcnt != width) {
+            rc = 1;
+            break; // problem sending a page out
+        }
+    }
+    set_disp_dc(SET_DISP_STATE_CMD);
+    wcnt = spi_write_blocking(g_gfxdata.spichan, full, sizeof(full));
+    if (wcnt != sizeof(full))
+        rc = 1;
+    return rc;
+}
+
+// RAM row 'line' is shown on the top of the display
+int ssd1309drv_disp_start_line(size_t line) {
+    uint8_t cmd = C_PRL_DSLINE(line);
+    int wcnt;
+    if (line >= SSD1309_PIX_HEIGHT)
+        return 1;
+    set_disp_dc(SET_DISP_STATE_CMD);
+    wcnt = spi_write_blocking(g_gfxdata.spichan, &cmd, 1);
+    return !(wcnt == 1);
+}
+
 uint8_t * ssd1309drv_disp_get_local_framebuffer(void) {
     return (uint8_t *)&(gfxFrameBuffer[0]);
 }
@@ -253,6 +300,8 @@ int ssd1309_probe(gfxDriver_p_p drvrStack) {
     drvrStack->get_DispPageHeight = &ssd1309_disp_get_DispPageHeight;
     drvrStack->get_drvrFrameBuffer = &ssd1309drv_disp_get_local_framebuffer;
     drvrStack->IsReady = &ssd1309drv_disp_is_ready;
+    drvrStack->refreshRegion = &ssd1309drv_disp_region;
+    drvrStack->set_startLine = &ssd1309drv_disp_start_line;
     // private control methods, BSP only
     drvrStack->Open = &ssd1309drv_disp_open;
     drvrStack->Init = &ssd1309drv_disp_init;
@@ -0,0 +1,197 @@
+// Host benchmarks for the cpyutils framebuffer kernels.
+//
+//   bench_cpyutils                     all benchmarks, table output
+//   bench_cpyutils --csv               machine readable, one line per case:
+//                                      name,iterations,ns_per_op,bytes_per_ns
+//   bench_cpyutils --iters N           override the iteration count
+//   bench_cpyutils <filter>            only cases whose name starts with filter
+//
+// Numbers are for the host CPU, use them to compare releases of the kernels
+// against each other, not to predict timings on the target.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cpyutils.h>
+#include "hostfb_driver.h"
+
+#define BENCH_ITERS     20000
+#define SPR_W           17
+#define SPR_PAGES       4
+
+typedef struct bench_ctx_type {
+    int     y;          /* blit row for the offset cases */
+    int     mode;       /* fill mode, blit overwrite     */
+    size_t  len;        /* buffer length for clear/merge */
+    size_t  offs;       /* misalign the buffers by this  */
+} bench_ctx_t;
+
+typedef struct bench_type {
+    const char * name;
+    size_t (*fn)(const bench_ctx_t * ctx);  /* one op, returns bytes written */
+    bench_ctx_t ctx;
+} bench_t;
+
+// 32 bit aligned work buffers, the 'offs' cases start 1 octet in
+static uint32_t buf_a32[(HOSTFB_LEN * 2) / 4 + 1];
+static uint32_t buf_b32[(HOSTFB_LEN * 2) / 4 + 1];
+static uint32_t buf_m32[(HOSTFB_LEN * 2) / 4 + 1];
+#define BUF_A   ((uint8_t *)buf_a32)
+#define BUF_B   ((uint8_t *)buf_b32)
+#define BUF_M   ((uint8_t *)buf_m32)
+
+static uint8_t spr[SPR_W * SPR_PAGES];
+static uint8_t spr_rle[SPR_W * SPR_PAGES * 2];
+static uint8_t rows_img[HOSTFB_LEN];
+static volatile uint8_t sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+// --- cases -----------------------------------------------------------------
+
+static size_t b_fb_clear(const bench_ctx_t * c) {
+    gfxutil_fb_clear(BUF_A + c->offs, c->len, c->mode);
+    return c->len;
+}
+
+static size_t b_fb_merge(const bench_ctx_t * c) {
+    gfxutil_fb_merge(BUF_A + c->offs, (c->mode) ? BUF_M + c->offs : NULL, BUF_B + c->offs, c->len);
+    return c->len;
+}
+
+static size_t b_blit(const bench_ctx_t * c) {
+    gfxutil_blit(spr, SPR_W, SPR_PAGES, c->mode, 40, c->y, BUF_B, HOSTFB_COLS, HOSTFB_PAGES);
+    return SPR_W * (SPR_PAGES + ((c->y & 7) ? 1 : 0));
+}
+
+static size_t b_blit_cached(const bench_ctx_t * c) {
+    gfxutil_blit_cached(spr, SPR_W, SPR_PAGES, c->mode, 40, c->y, BUF_B, HOSTFB_COLS, HOSTFB_PAGES);
+    return SPR_W * (SPR_PAGES + ((c->y & 7) ? 1 : 0));
+}
+
+static size_t b_rle_blit(const bench_ctx_t * c) {
+    gfxutil_rle_blit(spr_rle, SPR_W, SPR_PAGES, c->mode, 40, c->y, BUF_B, HOSTFB_COLS, HOSTFB_PAGES);
+    return SPR_W * (SPR_PAGES + ((c->y & 7) ? 1 : 0));
+}
+
+static size_t b_fbfb_copy(const bench_ctx_t * c) {
+    fbdata_t from, to;
+    memset(&from, 0, sizeof(from));
+    memset(&to, 0, sizeof(to));
+    from.fb_width = HOSTFB_COLS; from.fb_height = HOSTFB_PAGES * 8; from.rows_per_page = 8;
+    from.tl_posn_x = 8; from.tl_posn_y = 8; from.cpy_width = 96; from.cpy_height = 40;
+    from.ftb = (char *)BUF_A;
+    to.fb_width = HOSTFB_COLS; to.fb_height = HOSTFB_PAGES * 8; to.rows_per_page = 8;
+    to.tl_posn_x = 16; to.tl_posn_y = c->y;
+    to.ftb = (char *)BUF_B;
+    return (size_t)gfxutil_fbfb_copy(&from, &to);
+}
+
+static size_t b_fill_rect(const bench_ctx_t * c) {
+    return (size_t)gfxutil_fill_rect(BUF_B, HOSTFB_COLS, HOSTFB_PAGES, 4, c->y, 120, 50, c->mode);
+}
+
+static size_t b_rows_to_pages(const bench_ctx_t * c) {
+    gfxutil_rows_to_pages(rows_img, HOSTFB_COLS, HOSTFB_PAGES * 8, c->mode, BUF_B);
+    return HOSTFB_LEN;
+}
+
+static size_t b_pages_to_rows(const bench_ctx_t * c) {
+    gfxutil_pages_to_rows(BUF_A, HOSTFB_COLS, HOSTFB_PAGES * 8, c->mode, BUF_B);
+    return HOSTFB_LEN;
+}
+
+// name,             fn,             {y, mode, len, offs}
+static const bench_t benches[] = {
+    {"fb_clear_fast",        b_fb_clear,      {0, 1, HOSTFB_LEN, 0}},
+    {"fb_clear_memset",      b_fb_clear,      {0, 0, HOSTFB_LEN, 0}},
+    {"fb_merge_aligned",     b_fb_merge,      {0, 0, HOSTFB_LEN, 0}},
+    {"fb_merge_aligned_mask",b_fb_merge,      {0, 1, HOSTFB_LEN, 0}},
+    {"fb_merge_unaligned",   b_fb_merge,      {0, 0, HOSTFB_LEN - 1, 1}},
+    {"fb_merge_unaligned_mask", b_fb_merge,   {0, 1, HOSTFB_LEN - 1, 1}},
+    {"blit_y0",              b_blit,          {16, 1, 0, 0}},
+    {"blit_y1",              b_blit,          {17, 1, 0, 0}},
+    {"blit_y2",              b_blit,          {18, 1, 0, 0}},
+    {"blit_y3",              b_blit,          {19, 1, 0, 0}},
+    {"blit_y4",              b_blit,          {20, 1, 0, 0}},
+    {"blit_y5",              b_blit,          {21, 1, 0, 0}},
+    {"blit_y6",              b_blit,          {22, 1, 0, 0}},
+    {"blit_y7",              b_blit,          {23, 1, 0, 0}},
+    {"blit_or_y3",           b_blit,          {19, 0, 0, 0}},
+    {"blit_cached_y3",       b_blit_cached,   {19, 1, 0, 0}},
+    {"rle_blit_y0",          b_rle_blit,      {16, 1, 0, 0}},
+    {"rle_blit_y3",          b_rle_blit,      {19, 1, 0, 0}},
+    {"fbfb_copy_aligned",    b_fbfb_copy,     {16, 0, 0, 0}},
+    {"fbfb_copy_shifted",    b_fbfb_copy,     {19, 0, 0, 0}},
+    {"fill_rect_set",        b_fill_rect,     {5, GFXUTIL_FILL_SET, 0, 0}},
+    {"fill_rect_invert",     b_fill_rect,     {5, GFXUTIL_FILL_INVERT, 0, 0}},
+    {"rows_to_pages_msb",    b_rows_to_pages, {0, GFXUTIL_BITS_MSB_FIRST, 0, 0}},
+    {"pages_to_rows_msb",    b_pages_to_rows, {0, GFXUTIL_BITS_MSB_FIRST, 0, 0}},
+    {NULL, NULL, {0, 0, 0, 0}}
+};
+
+static void bench_setup(void) {
+    size_t i;
+    srand(34);
+    for (i = 0 ; i < sizeof(buf_a32) ; i++) {
+        BUF_A[i] = (uint8_t)rand();
+        BUF_M[i] = (uint8_t)rand();
+    }
+    for (i = 0 ; i < sizeof(spr) ; i++)
+        spr[i] = (i % 5) ? 0 : (uint8_t)rand();
+    for (i = 0 ; i < sizeof(rows_img) ; i++)
+        rows_img[i] = (uint8_t)rand();
+    gfxutil_rle_encode(spr, sizeof(spr), spr_rle, sizeof(spr_rle));
+    gfxutil_sprcache_init(4, SPR_W * (SPR_PAGES + 1));
+}
+
+int main(int argc, char ** argv) {
+    const bench_t * b;
+    const char * filter = NULL;
+    int csv = 0;
+    long iters = BENCH_ITERS;
+    int i;
+
+    for (i = 1 ; i < argc ; i++) {
+        if (strcmp(argv[i], "--csv") == 0)
+            csv = 1;
+        else if (strcmp(argv[i], "--iters") == 0 && (i + 1) < argc)
+            iters = atol(argv[++i]);
+        else
+            filter = argv[i];
+    }
+    if (iters < 1)
+        iters = 1;
+    bench_setup();
+
+    if (csv)
+        printf("name,iterations,ns_per_op,bytes_per_ns\n");
+    else
+        printf("%-26s %10s %12s %12s\n", "case", "iters", "ns/op", "bytes/ns");
+    for (b = benches ; b->name ; b++) {
+        uint64_t t0, t;
+        size_t bytes = 0;
+        double ns_op, b_ns;
+        long n;
+        if (filter && strncmp(b->name, filter, strlen(filter)) != 0)
+            continue;
+        b->fn(&b->ctx); // warm up, fills the sprite cache
+        t0 = now_ns();
+        for (n = 0 ; n < iters ; n++)
+            bytes += b->fn(&b->ctx);
+        t = now_ns() - t0;
+        sink = BUF_B[n & 0xff];
+        ns_op = (double)t / iters;
+        b_ns  = (t) ? (double)bytes / t : 0.0;
+        if (csv)
+            printf("%s,%ld,%.2f,%.3f\n", b->name, iters, ns_op, b_ns);
+        else
+            printf("%-26s %10ld %12.2f %12.3f\n", b->name, iters, ns_op, b_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Host benchmark for textgfx glyph rendering, in characters per second.
+//
+//   bench_textgfx                      table output
+//   bench_textgfx --csv                name,iterations,ns_per_op,chars_per_sec
+//   bench_textgfx --iters N            override the iteration count
+//   bench_textgfx --y N                static text box from pixel row N,
+//                                      off the page grid if N % 8 != 0
+//
+// Built twice: bench_textgfx with the RAM glyph atlas, bench_textgfx_flash
+// with glyphs unpacked from the flash font on each draw. Every op rewrites
+// all cells so the whole text buffer is rendered, the time includes the
+// compositor and the RAM panel write of one frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gfxDriverLowPriv.h>
+#include <textgfx.h>
+
+#define BENCH_ITERS     5000
+
+#ifndef TEXTGFX_USE_GLYPH_ATLAS
+  #define TEXTGFX_USE_GLYPH_ATLAS 0
+#endif
+
+static char screen_a[512];
+static char screen_b[512];
+static void * ftb = NULL;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+// two full screens differing in every cell
+static void bench_setup(void) {
+    int i, n = textgfx_get_width() * textgfx_get_height();
+    for (i = 0 ; i < n ; i++) {
+        screen_a[i] = (char)(0x21 + (i % 94));
+        screen_b[i] = (char)(0x21 + ((i + 47) % 94));
+    }
+    screen_a[n] = screen_b[n] = '\0';
+}
+
+static int b_static(long n) {
+    textgfx_cursor(0, 0);
+    textgfx_puts((n & 1) ? screen_b : screen_a);
+    textgfx_refresh();
+    return textgfx_get_width() * textgfx_get_height();
+}
+
+static int b_ftb(long n) {
+    ftbgfx_home(ftb);
+    ftbgfx_puts(ftb, (n & 1) ? screen_b + 7 : screen_a + 7);
+    ftbgfx_refresh(ftb);
+    return 16 * 4;
+}
+
+// the box walks a small square over the static text, as test_moving_textbox()
+static int b_ftb_move(long n) {
+    ftbgfx_move(ftb, 10 + (n & 7), 13 + ((n >> 3) & 7));
+    ftbgfx_refresh(ftb);
+    return 16 * 4;
+}
+
+typedef struct bench_type {
+    const char * name;
+    int (*fn)(long n);      /* one op, returns # chars rendered */
+} bench_t;
+
+static const bench_t benches[] = {
+    {"text_static",     b_static},
+    {"text_ftb",        b_ftb},
+    {"text_ftb_move",   b_ftb_move},
+    {NULL, NULL}
+};
+
+int main(int argc, char ** argv) {
+    const bench_t * b;
+    int csv = 0;
+    long iters = BENCH_ITERS;
+    int y = 0;
+    int i;
+
+    for (i = 1 ; i < argc ; i++) {
+        if (strcmp(argv[i], "--csv") == 0)
+            csv = 1;
+        else if (strcmp(argv[i], "--iters") == 0 && (i + 1) < argc)
+            iters = atol(argv[++i]);
+        else if (strcmp(argv[i], "--y") == 0 && (i + 1) < argc)
+            y = atoi(argv[++i]);
+    }
+    if (iters < 1)
+        iters = 1;
+
+    bsp_ConfigureGfxDriver();
+    bsp_StartGfxDriver();
+    if (text_init(SET_FB_LAYER_1) || textgfx_set_origin(TEXTGFX_ORIGIN_CENTRED, (uint)y) || textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) || ftbgfx_init()) {
+        printf("text layer init failed\n");
+        return 1;
+    }
+    ftb = ftbgfx_new(10, 13, 16, 4, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    if (!ftb) {
+        printf("no floating text box\n");
+        return 1;
+    }
+    bench_setup();
+
+    if (csv)
+        printf("name,iterations,ns_per_op,chars_per_sec\n");
+    else
+        printf("glyph atlas: %s, text from row %d\n%-26s %10s %12s %14s\n", (TEXTGFX_USE_GLYPH_ATLAS == 1) ? "on" : "off", y,
+            "case", "iters", "ns/op", "chars/s");
+    for (b = benches ; b->name ; b++) {
+        uint64_t t0, t;
+        uint64_t chars = 0;
+        double ns_op, cps;
+        long n;
+        b->fn(1); // warm up
+        t0 = now_ns();
+        for (n = 0 ; n < iters ; n++)
+            chars += b->fn(n);
+        t = now_ns() - t0;
+        ns_op = (double)t / iters;
+        cps = (t) ? (double)chars * 1e9 / t : 0.0;
+        if (csv)
+            printf("%s,%ld,%.2f,%.0f\n", b->name, iters, ns_op, cps);
+        else
+            printf("%-26s %10ld %12.2f %14.0f\n", b->name, iters, ns_op, cps);
+    }
+    return 0;
+}
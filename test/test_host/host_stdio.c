@@ -0,0 +1,33 @@
+/* Host stand-in for the pico SDK stdio driver list. See stub/pico/stdio/driver.h */
+
+#include "pico/stdio/driver.h"
+
+static stdio_driver_t * drivers = NULL;
+
+void stdio_set_driver_enabled(stdio_driver_t * driver, bool enabled) {
+    stdio_driver_t ** p = &drivers;
+    while (*p && *p != driver)
+        p = &((*p)->next);
+    if (enabled && !*p) {
+        driver->next = NULL;
+        *p = driver;
+    } else if (!enabled && *p) {
+        *p = driver->next;
+    }
+}
+
+void host_stdio_out(const char * buf, int len) {
+    stdio_driver_t * d;
+    for (d = drivers ; d ; d = d->next) {
+        if (d->out_chars)
+            d->out_chars(buf, len);
+    }
+}
+
+void host_stdio_flush(void) {
+    stdio_driver_t * d;
+    for (d = drivers ; d ; d = d->next) {
+        if (d->out_flush)
+            d->out_flush();
+    }
+}
@@ -0,0 +1,87 @@
+/* Host RAM "panel" standing in for the SSD1309 driver. See hostfb_driver.h */
+
+#include <string.h>
+#include <gfxDriverLowPriv.h>
+#include "hostfb_driver.h"
+
+uint8_t  hostfb_panel[HOSTFB_LEN] = {0};
+uint32_t hostfb_frames = 0;
+uint32_t hostfb_regions = 0;
+uint32_t hostfb_region_bytes = 0;
+uint32_t hostfb_start_line = 0;
+
+static uint8_t hostfb_fb[HOSTFB_LEN] = {0};
+static int     hostfb_ready = 0;
+
+static int hostfb_ok(void) { return 0; }
+static int hostfb_unsupported(int arg) { (void)arg; return 1; }
+
+static int hostfb_open(void) { return 0; }
+static int hostfb_init(void) { hostfb_ready = 1; return 0; }
+static int hostfb_close(void) { hostfb_ready = 0; return 0; }
+static int hostfb_is_ready(void) { return hostfb_ready; }
+
+static int hostfb_frame(const uint8_t * octets) {
+    if (!octets)
+        return 1;
+    memcpy(hostfb_panel, octets, HOSTFB_LEN);
+    hostfb_frames ++;
+    return 0;
+}
+
+static int hostfb_region(const uint8_t * octets, size_t col, size_t width, size_t page, size_t pages) {
+    size_t p;
+    if (!octets || !width || !pages || (col + width) > HOSTFB_COLS || (page + pages) > HOSTFB_PAGES)
+        return 1;
+    for (p = page ; p < (page + pages) ; p++)
+        memcpy(hostfb_panel + (p * HOSTFB_COLS) + col, octets + (p * HOSTFB_COLS) + col, width);
+    hostfb_regions ++;
+    hostfb_region_bytes += width * pages;
+    return 0;
+}
+
+static int hostfb_set_start_line(size_t line) {
+    if (line >= HOSTFB_PAGES * 8)
+        return 1;
+    hostfb_start_line = (uint32_t)line;
+    return 0;
+}
+
+static int hostfb_blank(void) {
+    memset(hostfb_panel, 0, HOSTFB_LEN);
+    return 0;
+}
+
+static const char * hostfb_name(void) { return "HOSTFB"; }
+static size_t hostfb_fbsize(void) { return HOSTFB_LEN; }
+static size_t hostfb_width(void) { return HOSTFB_COLS; }
+static size_t hostfb_height(void) { return HOSTFB_PAGES * 8; }
+static size_t hostfb_pages(void) { return HOSTFB_PAGES; }
+static uint8_t * hostfb_get_fb(void) { return hostfb_fb; }
+
+int ssd1309_probe(gfxDriver_p_p drvrStack) {
+    drvrStack->displayOn = &hostfb_ok;
+    drvrStack->displayOff = &hostfb_ok;
+    drvrStack->set_displayInvert = &hostfb_unsupported;
+    drvrStack->pset_displayFlipX = &hostfb_unsupported;
+    drvrStack->set_displayFlipY = &hostfb_unsupported;
+    drvrStack->set_displayRot = &hostfb_unsupported;
+    drvrStack->set_contrast = &hostfb_unsupported;
+    drvrStack->set_brightness = &hostfb_unsupported;
+    drvrStack->refreshDisplay = &hostfb_frame;
+    drvrStack->clearDisplay = &hostfb_blank;
+    drvrStack->driverName = &hostfb_name;
+    drvrStack->get_FBSize = &hostfb_fbsize;
+    drvrStack->get_DispWidth = &hostfb_width;
+    drvrStack->get_DispHeight = &hostfb_height;
+    drvrStack->get_DispPageHeight = &hostfb_pages;
+    drvrStack->get_drvrFrameBuffer = &hostfb_get_fb;
+    drvrStack->IsReady = &hostfb_is_ready;
+    drvrStack->refreshRegion = &hostfb_region;
+    drvrStack->set_startLine = &hostfb_set_start_line;
+    drvrStack->Open = &hostfb_open;
+    drvrStack->Init = &hostfb_init;
+    drvrStack->Close = &hostfb_close;
+    drvrStack->dinfo = NULL;
+    return 0;
+}
@@ -0,0 +1,22 @@
+/* Host RAM "panel" standing in for the SSD1309 driver.
+ *
+ * The BSP probes drivers by name (GFX_DRIVER_LL_STACK, default "SSD1309") so 
+ * this file provides ssd1309_probe(). Frames written to the display land in
+ * hostfb_panel[] where a test can check them.
+ */
+#ifndef HOSTFB_DRIVER_H
+#define HOSTFB_DRIVER_H
+
+#include <stdint.h>
+
+#define HOSTFB_COLS     128
+#define HOSTFB_PAGES    8
+#define HOSTFB_LEN      (HOSTFB_COLS * HOSTFB_PAGES)
+
+extern uint8_t  hostfb_panel[HOSTFB_LEN];   /* what is "on screen" */
+extern uint32_t hostfb_frames;              /* # refreshDisplay() calls */
+extern uint32_t hostfb_regions;             /* # refreshRegion() calls */
+extern uint32_t hostfb_region_bytes;        /* octets written by refreshRegion() */
+extern uint32_t hostfb_start_line;          /* panel row shown on top, set_startLine() */
+
+#endif /* HOSTFB_DRIVER_H */
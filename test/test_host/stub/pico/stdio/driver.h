@@ -0,0 +1,26 @@
+/* Host build stand-in for the pico SDK header of the same name.
+ * Only what the display stack uses. host_stdio.c keeps the list of
+ * enabled drivers, host_stdio_out() is what printf() would hand them.
+ */
+#ifndef HOST_PICO_STDIO_DRIVER_H
+#define HOST_PICO_STDIO_DRIVER_H
+
+#include "pico/types.h"
+
+typedef struct stdio_driver stdio_driver_t;
+
+struct stdio_driver {
+    void (*out_chars)(const char * buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char * buf, int len);
+    void (*set_chars_available_callback)(void (*fn)(void *), void * param);
+    stdio_driver_t * next;
+};
+
+void stdio_set_driver_enabled(stdio_driver_t * driver, bool enabled);
+
+// host only
+void host_stdio_out(const char * buf, int len);
+void host_stdio_flush(void);
+
+#endif /* HOST_PICO_STDIO_DRIVER_H */
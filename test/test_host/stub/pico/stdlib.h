@@ -0,0 +1,29 @@
+/* Host build stand-in for the pico SDK header of the same name.
+ * Only what the display stack uses.
+ */
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <time.h>
+#include "pico/types.h"
+
+static inline uint64_t time_us_64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ull) + (ts.tv_nsec / 1000);
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+static inline void sleep_us(uint64_t us) {
+    struct timespec ts = { (time_t)(us / 1000000ull), (long)((us % 1000000ull) * 1000) };
+    nanosleep(&ts, NULL);
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000ull);
+}
+
+#endif /* HOST_PICO_STDLIB_H */
@@ -0,0 +1,13 @@
+/* Host build stand-in for the pico SDK header of the same name.
+ * Only what the display stack uses.
+ */
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#endif /* HOST_PICO_TYPES_H */
@@ -0,0 +1,1919 @@
+// Host tests for the display stack.
+// Runs against the RAM panel in hostfb_driver.c. Each test is run in its
+// own process (see CMakeLists.txt) as the compositor layers are global and
+// cannot be released once registered.
+//
+//   test_host_gfx            list the tests
+//   test_host_gfx <name>     run one test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "pico/stdlib.h"
+#include <gfxDriverLowPriv.h>
+#include <cpyutils.h>
+#include <led_overlay.h>
+#include <linegfx.h>
+#include <textgfx.h>
+#include <textvt.h>
+#include "pico/stdio/driver.h"
+#include "hostfb_driver.h"
+
+static int check_fail = 0;
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        check_fail ++; } } while (0)
+
+static void start_driver(void) {
+    bsp_ConfigureGfxDriver();
+    bsp_StartGfxDriver();
+}
+
+// ----------------------------------------------------------------------------
+// seqlock layer publish, concurrent writers vs the compositor
+// ----------------------------------------------------------------------------
+
+#define SEQ_RUN_US      300000  /* how long the writers hammer the layers */
+#define SEQ_A_PRIO      SET_FB_LAYER_2
+#define SEQ_A_X         8
+#define SEQ_A_PAGE      1
+#define SEQ_A_W         32
+#define SEQ_A_PAGES     2
+#define SEQ_B_PRIO      SET_FB_LAYER_FOREGROUND
+#define SEQ_B_X         64
+#define SEQ_B_PAGE      4
+#define SEQ_B_W         48
+#define SEQ_B_PAGES     3
+
+static uint8_t seq_layer_a[HOSTFB_LEN];
+static uint8_t seq_layer_b[HOSTFB_LEN * 2]; // has a mask
+static volatile int seq_stop = 0;
+
+typedef struct seq_writer_type {
+    uint8_t prio;
+    size_t  x, page, w, pages;
+    int     use_mask;
+    uint32_t published;
+} seq_writer_t;
+
+static void * seq_writer(void * arg) {
+    seq_writer_t * wr = (seq_writer_t *)arg;
+    uint8_t pix[SEQ_B_W * SEQ_B_PAGES];
+    uint8_t mask[SEQ_B_W * SEQ_B_PAGES];
+    uint8_t v = 1;
+    volatile int i;
+    memset(mask, 0xff, sizeof(mask));
+    while (!seq_stop) {
+        memset(pix, v, wr->w * wr->pages);
+        gfx_layerPublish(wr->prio, wr->x, wr->page, wr->w, wr->pages, pix,
+            (wr->use_mask) ? mask : NULL);
+        wr->published ++;
+        v = (v == 0xff) ? 1 : v + 1;
+        for (i = 0 ; i < 200 ; i++) {
+            (void)seq_stop; // short spin between publishes, keeps both sides busy
+        }
+    }
+    return NULL;
+}
+
+// all octets in the rectangle hold the same value, return it or -1 if torn
+static int rect_uniform(const uint8_t * fb, size_t x, size_t page, size_t w, size_t pages) {
+    uint8_t v = fb[page * HOSTFB_COLS + x];
+    size_t i, p;
+    for (p = page ; p < page + pages ; p++)
+        for (i = x ; i < x + w ; i++)
+            if (fb[p * HOSTFB_COLS + i] != v)
+                return -1;
+    return v;
+}
+
+static void test_seqlock_stress(void) {
+    pthread_t ta, tb;
+    seq_writer_t wa = {SEQ_A_PRIO, SEQ_A_X, SEQ_A_PAGE, SEQ_A_W, SEQ_A_PAGES, 0, 0};
+    seq_writer_t wb = {SEQ_B_PRIO, SEQ_B_X, SEQ_B_PAGE, SEQ_B_W, SEQ_B_PAGES, 1, 0};
+    uint8_t * drvr_fb;
+    int rc;
+    uint64_t t_end;
+    int clean = 0, torn_reported = 0, torn_missed = 0, changes = 0;
+    int last_a = -1;
+    gfx_stats_t st;
+
+    start_driver();
+    drvr_fb = gfx_getFrameBuffer();
+    CHECK(gfx_setFrameBufferLayerPrio(seq_layer_a, SEQ_A_PRIO, FB_NO_MASK) == 0);
+    CHECK(gfx_setFrameBufferLayerPrio(seq_layer_b, SEQ_B_PRIO, FB_HAS_MASK) == 0);
+    gfx_resetStats();
+
+    pthread_create(&ta, NULL, seq_writer, &wa);
+    pthread_create(&tb, NULL, seq_writer, &wb);
+    t_end = time_us_64() + SEQ_RUN_US;
+    while (time_us_64() < t_end) {
+        rc = gfx_fb_compositor();
+        if (rc == 0) {
+            int a = rect_uniform(drvr_fb, SEQ_A_X, SEQ_A_PAGE, SEQ_A_W, SEQ_A_PAGES);
+            int b = rect_uniform(drvr_fb, SEQ_B_X, SEQ_B_PAGE, SEQ_B_W, SEQ_B_PAGES);
+            if (a < 0 || b < 0) {
+                torn_missed ++;
+            }
+            if (a != last_a) {
+                changes ++;
+                last_a = a;
+            }
+            clean ++;
+        } else if (rc == 2) {
+            torn_reported ++;
+        }
+    }
+    seq_stop = 1;
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+
+    printf("  frames clean:%d torn(reported):%d torn(missed):%d, publishes a:%u b:%u\n",
+        clean, torn_reported, torn_missed, wa.published, wb.published);
+    CHECK(torn_missed == 0);
+    CHECK(clean > torn_reported);
+    CHECK(changes > 1);
+    CHECK(gfx_getStats(&st) == 0);
+    printf("  compose retries: %u\n", st.compose_retries);
+
+    // change detection for the main loop
+    gfx_fb_compositor();
+    CHECK(gfx_layersChanged() == 0);
+    {
+        uint8_t glyph[8] = {0x3c, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3c};
+        CHECK(gfx_layerPublish(SEQ_A_PRIO, 0, 0, 8, 1, glyph, NULL) == 0);
+        CHECK(gfx_layersChanged() == 1);
+        CHECK(gfx_displayRefresh() == 0);
+        CHECK(gfx_layersChanged() == 0);
+        CHECK(memcmp(hostfb_panel, glyph, 8) == 0);
+        // off screen, unregistered layer
+        CHECK(gfx_layerPublish(SEQ_A_PRIO, HOSTFB_COLS - 4, 0, 8, 1, glyph, NULL) == 1);
+        CHECK(gfx_layerPublish(SET_FB_LAYER_BACKGROUND, 0, 0, 8, 1, glyph, NULL) == 1);
+    }
+    CHECK(gfx_getStats(&st) == 0);
+    CHECK(st.frames == 1);
+    CHECK(st.bytes_sent == HOSTFB_LEN);
+
+    // a write that outlasts all the retries: reported, and redrawn once done
+    gfx_layerWriteBegin(SEQ_B_PRIO);
+    memset(seq_layer_b + (SEQ_B_PAGE * HOSTFB_COLS) + SEQ_B_X, 0x81, SEQ_B_W);
+    CHECK(gfx_fb_compositor() == 2);
+    CHECK(gfx_layersChanged() == 1);
+    CHECK(gfx_displayRefresh() == 2);
+    CHECK(gfx_layersChanged() == 1);
+    gfx_layerWriteEnd(SEQ_B_PRIO);
+    CHECK(gfx_displayRefresh() == 0);
+    CHECK(gfx_layersChanged() == 0);
+    CHECK(memcmp(hostfb_panel, drvr_fb, HOSTFB_LEN) == 0);
+    CHECK(hostfb_panel[(SEQ_B_PAGE * HOSTFB_COLS) + SEQ_B_X] == 0x81);
+
+    // region refreshes while a writer publishes: whatever the compositor
+    // merged reaches the panel, the ISR pixels are not left out
+    seq_stop = 0;
+    pthread_create(&ta, NULL, seq_writer, &wa);
+    torn_missed = 0;
+    t_end = time_us_64() + (SEQ_RUN_US / 3);
+    while (time_us_64() < t_end) {
+        gfx_addDamage(0, 7 * 8, 8, 8); // a little text change
+        rc = gfx_displayRefresh();
+        CHECK(rc == 0 || rc == 2);
+        if (memcmp(hostfb_panel, drvr_fb, HOSTFB_LEN) != 0)
+            torn_missed ++;
+    }
+    seq_stop = 1;
+    pthread_join(ta, NULL);
+    CHECK(torn_missed == 0);
+}
+
+// ----------------------------------------------------------------------------
+// rect copy kernels vs a pixel by pixel reference
+// ----------------------------------------------------------------------------
+
+#define RC_ROUNDS   4000
+
+static int px_get(const uint8_t * fb, int w, int x, int y) {
+    return (fb[(y / 8) * w + x] >> (y % 8)) & 1;
+}
+
+static void px_set(uint8_t * fb, int w, int x, int y, int v) {
+    if (v)
+        fb[(y / 8) * w + x] |= (uint8_t)(1 << (y % 8));
+    else
+        fb[(y / 8) * w + x] &= (uint8_t)~(1 << (y % 8));
+}
+
+static void fill_random(uint8_t * b, size_t len) {
+    size_t i;
+    for (i = 0 ; i < len ; i++)
+        b[i] = (uint8_t)rand();
+}
+
+static void test_rect_copy(void) {
+    uint8_t src[40 * 3];    // 40 x 20 pixel source (3 pages, last one partial)
+    uint8_t dst[HOSTFB_LEN];
+    uint8_t ref[HOSTFB_LEN];
+    fbdata_t from, to;
+    int round, bad = 0, written = 0;
+
+    srand(28);
+    for (round = 0 ; round < RC_ROUNDS ; round++) {
+        int x, y, w, h, n = 0;
+        fill_random(src, sizeof(src));
+        fill_random(dst, sizeof(dst));
+        memcpy(ref, dst, sizeof(dst));
+        memset(&from, 0, sizeof(from));
+        memset(&to, 0, sizeof(to));
+        from.fb_width = 40; from.fb_height = 20; from.rows_per_page = 8;
+        from.tl_posn_x = rand() % 44;  from.tl_posn_y = rand() % 24;
+        from.cpy_width = rand() % 48;  from.cpy_height = rand() % 24;
+        from.ftb = (char *)src;
+        to.fb_width = HOSTFB_COLS; to.fb_height = HOSTFB_PAGES * 8; to.rows_per_page = 8;
+        to.tl_posn_x = rand() % 140; to.tl_posn_y = rand() % 72;
+        to.ftb = (char *)dst;
+
+        w = (from.cpy_width)  ? from.cpy_width  : from.fb_width  - from.tl_posn_x;
+        h = (from.cpy_height) ? from.cpy_height : from.fb_height - from.tl_posn_y;
+        for (y = 0 ; y < h ; y++) {
+            for (x = 0 ; x < w ; x++) {
+                int fx = from.tl_posn_x + x, fy = from.tl_posn_y + y;
+                int tx = to.tl_posn_x + x,   ty = to.tl_posn_y + y;
+                if (fx >= from.fb_width || fy >= from.fb_height || tx >= to.fb_width || ty >= to.fb_height)
+                    continue;
+                px_set(ref, HOSTFB_COLS, tx, ty, px_get(src, 40, fx, fy));
+                n ++;
+            }
+        }
+        written = gfxutil_fbfb_copy(&from, &to);
+        if (memcmp(dst, ref, sizeof(dst)) != 0 || (n == 0 && written != 0) || (n && written <= 0))
+            bad ++;
+    }
+    CHECK(bad == 0);
+
+    // text buffer, clipped on the right and bottom
+    {
+        static const uint8_t font[3 * GFXUTIL_TXT_GLYPH_W] = {
+            0x00, 0x00, 0x00, 0x00, 0x00,
+            0xff, 0x81, 0x81, 0x81, 0xff,
+            0x01, 0x02, 0x04, 0x08, 0x10 };
+        char txt[4] = {1, 2, 2, 1};  // 2 x 2 chars
+        int x, y;
+        memset(&from, 0, sizeof(from));
+        memset(&to, 0, sizeof(to));
+        from.fb_width = 2; from.fb_height = 2;
+        from.ftb = txt; from.font = font;
+        to.fb_width = HOSTFB_COLS; to.fb_height = HOSTFB_PAGES * 8; to.rows_per_page = 8;
+        to.tl_posn_x = HOSTFB_COLS - 9; to.tl_posn_y = 59;
+        to.ftb = (char *)dst;
+        memset(dst, 0xaa, sizeof(dst));
+        memcpy(ref, dst, sizeof(dst));
+        for (y = 0 ; y < 16 ; y++) {
+            for (x = 0 ; x < 12 ; x++) {
+                int tx = to.tl_posn_x + x, ty = to.tl_posn_y + y;
+                int c = txt[(y / 8) * 2 + (x / 6)];
+                int v = (x % 6 < 5) ? (font[c * 5 + (x % 6)] & 0x7f) >> (y % 8) & 1 : 0;
+                if (tx < HOSTFB_COLS && ty < HOSTFB_PAGES * 8)
+                    px_set(ref, HOSTFB_COLS, tx, ty, v);
+            }
+        }
+        CHECK(gfxutil_tbfb_copy(&from, &to) > 0);
+        CHECK(memcmp(dst, ref, sizeof(dst)) == 0);
+        from.font = NULL;
+        CHECK(gfxutil_tbfb_copy(&from, &to) == -1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// clipped blit, sprites partially off every edge
+// ----------------------------------------------------------------------------
+
+#define BLIT_ROUNDS     4000
+#define BLIT_GUARD      64
+#define BLIT_SPR_W      17
+#define BLIT_SPR_PAGES  4
+
+static void test_blit_clip(void) {
+    uint8_t spr[BLIT_SPR_W * BLIT_SPR_PAGES];
+    uint8_t buf[BLIT_GUARD + HOSTFB_LEN + BLIT_GUARD];
+    uint8_t * dst = buf + BLIT_GUARD;
+    uint8_t ref[HOSTFB_LEN];
+    int round, bad = 0, guard_hit = 0, i;
+
+    srand(29);
+    for (round = 0 ; round < BLIT_ROUNDS ; round++) {
+        int at_x = (rand() % (HOSTFB_COLS + 2 * BLIT_SPR_W)) - BLIT_SPR_W - 2;
+        int at_y = (rand() % (HOSTFB_PAGES * 8 + 2 * 32)) - 34;
+        bool overwrite = rand() & 1;
+        int x, y;
+        fill_random(spr, sizeof(spr));
+        memset(buf, 0x5a, sizeof(buf));
+        fill_random(dst, HOSTFB_LEN);
+        memcpy(ref, dst, HOSTFB_LEN);
+        for (y = 0 ; y < BLIT_SPR_PAGES * 8 ; y++) {
+            for (x = 0 ; x < BLIT_SPR_W ; x++) {
+                int tx = at_x + x, ty = at_y + y;
+                int v = px_get(spr, BLIT_SPR_W, x, y);
+                if (tx < 0 || ty < 0 || tx >= HOSTFB_COLS || ty >= HOSTFB_PAGES * 8)
+                    continue;
+                if (overwrite || v)
+                    px_set(ref, HOSTFB_COLS, tx, ty, v);
+            }
+        }
+        CHECK(gfxutil_blit(spr, BLIT_SPR_W, BLIT_SPR_PAGES, overwrite, at_x, at_y,
+            dst, HOSTFB_COLS, HOSTFB_PAGES) == 0);
+        if (memcmp(dst, ref, HOSTFB_LEN) != 0)
+            bad ++;
+        for (i = 0 ; i < BLIT_GUARD ; i++) {
+            if (buf[i] != 0x5a || dst[HOSTFB_LEN + i] != 0x5a) {
+                guard_hit ++;
+                break;
+            }
+        }
+    }
+    CHECK(bad == 0);
+    CHECK(guard_hit == 0);
+    CHECK(gfxutil_blit(NULL, BLIT_SPR_W, BLIT_SPR_PAGES, true, 0, 0, dst, HOSTFB_COLS, HOSTFB_PAGES) == 1);
+}
+
+// ----------------------------------------------------------------------------
+// sprite cache, cached blits match plain blits
+// ----------------------------------------------------------------------------
+
+#define SPR_ROUNDS      3000
+#define SPR_BITMAPS     6
+#define SPR_SLOTS       4
+
+static void test_sprite_cache(void) {
+    static uint8_t bmaps[SPR_BITMAPS][BLIT_SPR_W * BLIT_SPR_PAGES];
+    uint8_t dst[HOSTFB_LEN];
+    uint8_t ref[HOSTFB_LEN];
+    gfxutil_sprcache_stats_t st;
+    int round, bad = 0, i;
+
+    srand(30);
+    for (i = 0 ; i < SPR_BITMAPS ; i++)
+        fill_random(bmaps[i], sizeof(bmaps[i]));
+    // not running yet, everything bypasses
+    CHECK(gfxutil_blit_cached(bmaps[0], BLIT_SPR_W, BLIT_SPR_PAGES, true, 3, 5, dst, HOSTFB_COLS, HOSTFB_PAGES) == 0);
+    CHECK(gfxutil_sprcache_getStats(&st) == 0 && st.bypass == 1);
+    CHECK(gfxutil_sprcache_init(SPR_SLOTS, BLIT_SPR_W * (BLIT_SPR_PAGES + 1)) == 0);
+    CHECK(gfxutil_sprcache_init(SPR_SLOTS, BLIT_SPR_W * (BLIT_SPR_PAGES + 1)) == 1);
+    gfxutil_sprcache_resetStats();
+
+    fill_random(dst, sizeof(dst));
+    memcpy(ref, dst, sizeof(dst));
+    for (round = 0 ; round < SPR_ROUNDS ; round++) {
+        // a few hot bitmaps and offsets so there are hits, misses and evictions
+        int b = (rand() % 4) ? rand() % 2 : rand() % SPR_BITMAPS;
+        int at_x = (rand() % (HOSTFB_COLS + 2 * BLIT_SPR_W)) - BLIT_SPR_W - 2;
+        int at_y = ((rand() % 10) * 8) - 20 + ((rand() % 4) ? 3 : rand() % 8);
+        bool overwrite = rand() & 1;
+        gfxutil_blit(bmaps[b], BLIT_SPR_W, BLIT_SPR_PAGES, overwrite, at_x, at_y, ref, HOSTFB_COLS, HOSTFB_PAGES);
+        CHECK(gfxutil_blit_cached(bmaps[b], BLIT_SPR_W, BLIT_SPR_PAGES, overwrite, at_x, at_y,
+            dst, HOSTFB_COLS, HOSTFB_PAGES) == 0);
+        if (memcmp(dst, ref, sizeof(dst)) != 0)
+            bad ++;
+    }
+    CHECK(bad == 0);
+    CHECK(gfxutil_sprcache_getStats(&st) == 0);
+    printf("  hits:%u misses:%u evictions:%u bypass:%u\n", st.hits, st.misses, st.evictions, st.bypass);
+    CHECK(st.hits > st.misses);
+    CHECK(st.evictions > 0);
+    CHECK(st.bypass > 0);   // page aligned blits
+    CHECK(st.hits + st.misses + st.bypass == SPR_ROUNDS);
+
+    // too large for a slot
+    gfxutil_sprcache_resetStats();
+    CHECK(gfxutil_blit_cached(dst, HOSTFB_COLS, 2, false, 0, 3, ref, HOSTFB_COLS, HOSTFB_PAGES) == 0);
+    CHECK(gfxutil_sprcache_getStats(&st) == 0 && st.bypass == 1);
+}
+
+// ----------------------------------------------------------------------------
+// RLE bitmaps, decoded output vs the raw bitmaps
+// ----------------------------------------------------------------------------
+
+#define RLE_ROUNDS      3000
+#define LED_DIG_W       17
+#define LED_DIG_PAGES   4
+#define LED_DIG_SPACE   2
+
+// raw form of the RLE digits in led_overlay.c, blank then 0..9
+static const uint8_t raw_digits[11][LED_DIG_W * LED_DIG_PAGES] = {
+    { // bmap_dig_blank
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { // bmap_dig_0
+      0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x3f, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f,
+      0xfe, 0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe,
+      0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f },
+    { // bmap_dig_1
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xfc, 0xf8,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f },
+    { // bmap_dig_2
+      0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x00, 0x00, 0x80, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f,
+      0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+      0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x40, 0x00, 0x00 },
+    { // bmap_dig_3
+      0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x00, 0x00, 0x80, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f,
+      0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x40, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f },
+    { // bmap_dig_4
+      0xf8, 0xfc, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xfc, 0xf8,
+      0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f,
+      0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f },
+    { // bmap_dig_5
+      0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00,
+      0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x40, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f },
+    { // bmap_dig_6
+      0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00,
+      0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x00, 0x00,
+      0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f },
+    { // bmap_dig_7
+      0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x7f, 0x3f,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f },
+    { // bmap_dig_8
+      0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f,
+      0xfe, 0xff, 0xfe, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x1f, 0x3f, 0x5f, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0x5f, 0x3f, 0x1f },
+    { // bmap_dig_9
+      0xf8, 0xfc, 0xfa, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xfa, 0xfc, 0xf8,
+      0x3f, 0x7f, 0xbf, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xbf, 0x7f, 0x3f,
+      0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xff, 0xfe,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x3f, 0x1f } };
+
+static void rle_check_bitmap(const uint8_t * bm, size_t w, size_t pages, int * bad) {
+    uint8_t rle[HOSTFB_LEN + HOSTFB_LEN / 128 + 1];
+    uint8_t dst[HOSTFB_LEN];
+    uint8_t ref[HOSTFB_LEN];
+    int len = gfxutil_rle_encode(bm, w * pages, rle, sizeof(rle));
+    int i;
+    CHECK(len > 0);
+    for (i = 0 ; i < 8 ; i++) {
+        int at_x = (rand() % (HOSTFB_COLS + 2 * (int)w)) - (int)w - 2;
+        int at_y = (rand() % (HOSTFB_PAGES * 8 + 2 * (int)pages * 8)) - (int)pages * 8 - 2;
+        bool overwrite = rand() & 1;
+        fill_random(dst, sizeof(dst));
+        memcpy(ref, dst, sizeof(dst));
+        gfxutil_blit(bm, w, pages, overwrite, at_x, at_y, ref, HOSTFB_COLS, HOSTFB_PAGES);
+        CHECK(gfxutil_rle_blit(rle, w, pages, overwrite, at_x, at_y, dst, HOSTFB_COLS, HOSTFB_PAGES) == 0);
+        if (memcmp(dst, ref, sizeof(dst)) != 0)
+            (*bad) ++;
+    }
+}
+
+static void led_expect(uint8_t * fb, int x, int y, const int * dig, int n) {
+    int i;
+    memset(fb, 0, HOSTFB_LEN);
+    for (i = 0 ; i < n ; i++) {
+        gfxutil_blit(raw_digits[dig[i]], LED_DIG_W, LED_DIG_PAGES, true, x, y, fb, HOSTFB_COLS, HOSTFB_PAGES);
+        x += LED_DIG_W + LED_DIG_SPACE;
+    }
+}
+
+static void test_rle_bitmaps(void) {
+    uint8_t bm[HOSTFB_LEN];
+    uint8_t fb[HOSTFB_LEN];
+    int round, bad = 0, i;
+
+    srand(31);
+    for (i = 0 ; i < 11 ; i++)
+        rle_check_bitmap(raw_digits[i], LED_DIG_W, LED_DIG_PAGES, &bad);
+    // random widths, runs of every length including across pages and > 129
+    for (round = 0 ; round < RLE_ROUNDS ; round++) {
+        size_t w = 1 + rand() % 80;
+        size_t pages = 1 + rand() % 6;
+        size_t j = 0;
+        while (j < w * pages) {
+            size_t run = 1 + ((rand() % 3) ? rand() % 4 : rand() % 300);
+            uint8_t v = (rand() % 3) ? 0 : (uint8_t)rand();
+            while (run-- && j < w * pages)
+                bm[j++] = (rand() % 8) ? v : (uint8_t)rand();
+        }
+        rle_check_bitmap(bm, w, pages, &bad);
+    }
+    CHECK(bad == 0);
+    CHECK(gfxutil_rle_encode(bm, 64, bm + 512, 4) == -1);
+
+    // led_overlay renders its RLE digits the same as the raw bitmaps
+    start_driver();
+    CHECK(led0_init(SET_FB_LAYER_2) == 0);
+    {
+        int d907[3] = {10, 1, 8};
+        int d42[3]  = {0, 5, 3};
+        void * led = ledo_open(5, 13, 3, 907, 1);
+        CHECK(led != NULL);
+        led_expect(fb, 5, 13, d907, 3);
+        CHECK(memcmp(hostfb_panel, fb, HOSTFB_LEN) == 0);
+        CHECK(ledo_update(led, 42) == 0);
+        led_expect(fb, 5, 13, d42, 3);
+        CHECK(memcmp(hostfb_panel, fb, HOSTFB_LEN) == 0);
+        ledo_close(&led);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// row-major <--> page format, vs a per-pixel loop
+// ----------------------------------------------------------------------------
+
+#define TP_ROUNDS       500
+#define TP_BENCH_LOOPS  2000
+
+static int row_px(const uint8_t * img, size_t w, size_t x, size_t y, int order) {
+    uint8_t o = img[y * ((w + 7) / 8) + (x / 8)];
+    return (order == GFXUTIL_BITS_MSB_FIRST) ? (o >> (7 - (x % 8))) & 1 : (o >> (x % 8)) & 1;
+}
+
+static void naive_rows_to_pages(const uint8_t * from, size_t w, size_t h, int order, uint8_t * to) {
+    size_t x, y;
+    memset(to, 0, w * ((h + 7) / 8));
+    for (y = 0 ; y < h ; y++)
+        for (x = 0 ; x < w ; x++)
+            px_set(to, (int)w, (int)x, (int)y, row_px(from, w, x, y, order));
+}
+
+static void test_transpose(void) {
+    static uint8_t img[200 * 25];
+    static uint8_t pg[200 * 25];
+    static uint8_t ref[200 * 25];
+    static uint8_t back[200 * 25];
+    int round, bad = 0, bad_back = 0, i;
+    uint64_t t0, t_naive, t_fast;
+
+    srand(32);
+    for (round = 0 ; round < TP_ROUNDS ; round++) {
+        size_t w = 1 + rand() % 200;
+        size_t h = 1 + rand() % 200;
+        size_t stride = (w + 7) / 8;
+        int order = rand() & 1;
+        size_t x, y;
+        fill_random(img, stride * h);
+        // clear the row padding so the round trip compares equal
+        for (y = 0 ; y < h ; y++)
+            for (x = w ; x < stride * 8 ; x++)
+                img[y * stride + x / 8] &= (order == GFXUTIL_BITS_MSB_FIRST) ? ~(0x80 >> (x % 8)) : ~(1 << (x % 8));
+        naive_rows_to_pages(img, w, h, order, ref);
+        CHECK(gfxutil_rows_to_pages(img, w, h, order, pg) == 0);
+        if (memcmp(pg, ref, w * ((h + 7) / 8)) != 0)
+            bad ++;
+        memset(back, 0xa5, sizeof(back));
+        CHECK(gfxutil_pages_to_rows(pg, w, h, order, back) == 0);
+        if (memcmp(back, img, stride * h) != 0)
+            bad_back ++;
+    }
+    CHECK(bad == 0);
+    CHECK(bad_back == 0);
+    CHECK(gfxutil_rows_to_pages(NULL, 8, 8, 0, pg) == 1);
+
+    // full screen conversion, kernel vs per-pixel loop
+    fill_random(img, HOSTFB_LEN);
+    t0 = time_us_64();
+    for (i = 0 ; i < TP_BENCH_LOOPS ; i++)
+        naive_rows_to_pages(img, HOSTFB_COLS, HOSTFB_PAGES * 8, GFXUTIL_BITS_MSB_FIRST, ref);
+    t_naive = time_us_64() - t0;
+    t0 = time_us_64();
+    for (i = 0 ; i < TP_BENCH_LOOPS ; i++)
+        gfxutil_rows_to_pages(img, HOSTFB_COLS, HOSTFB_PAGES * 8, GFXUTIL_BITS_MSB_FIRST, pg);
+    t_fast = time_us_64() - t0;
+    CHECK(memcmp(pg, ref, HOSTFB_LEN) == 0);
+    printf("  128x64 rows_to_pages: per-pixel %.2f us, 8x8 transpose %.2f us\n",
+        (double)t_naive / TP_BENCH_LOOPS, (double)t_fast / TP_BENCH_LOOPS);
+}
+
+// ----------------------------------------------------------------------------
+// rect fill kernel and the linegfx shapes using it
+// ----------------------------------------------------------------------------
+
+#define FILL_ROUNDS     4000
+
+static void ref_fill(uint8_t * fb, int x, int y, int w, int h, int mode) {
+    int i, j;
+    for (j = y ; j < y + h ; j++) {
+        for (i = x ; i < x + w ; i++) {
+            if (i < 0 || j < 0 || i >= HOSTFB_COLS || j >= HOSTFB_PAGES * 8)
+                continue;
+            if (mode == GFXUTIL_FILL_SET)
+                px_set(fb, HOSTFB_COLS, i, j, 1);
+            else if (mode == GFXUTIL_FILL_CLEAR)
+                px_set(fb, HOSTFB_COLS, i, j, 0);
+            else
+                px_set(fb, HOSTFB_COLS, i, j, !px_get(fb, HOSTFB_COLS, i, j));
+        }
+    }
+}
+
+static void test_fill_rect(void) {
+    uint8_t dst[HOSTFB_LEN];
+    uint8_t ref[HOSTFB_LEN];
+    int round, bad = 0;
+
+    srand(33);
+    for (round = 0 ; round < FILL_ROUNDS ; round++) {
+        int x = (rand() % 160) - 16, y = (rand() % 90) - 13;
+        int w = rand() % 140, h = rand() % 80;
+        int mode = rand() % 3;
+        fill_random(dst, sizeof(dst));
+        memcpy(ref, dst, sizeof(dst));
+        ref_fill(ref, x, y, w, h, mode);
+        CHECK(gfxutil_fill_rect(dst, HOSTFB_COLS, HOSTFB_PAGES, x, y, w, h, mode) >= 0);
+        if (memcmp(dst, ref, sizeof(dst)) != 0)
+            bad ++;
+    }
+    CHECK(bad == 0);
+    CHECK(gfxutil_fill_rect(dst, HOSTFB_COLS, HOSTFB_PAGES, 0, 0, 8, 8, 7) == -1);
+
+    // linegfx
+    start_driver();
+    CHECK(lgfx_init(SET_FB_LAYER_2) == 0);
+    memset(ref, 0, sizeof(ref));
+    CHECK(lgfx_filled_box(100, 50, 3, 5, COLOUR_BLK) == 0);
+    ref_fill(ref, 3, 5, 98, 46, GFXUTIL_FILL_SET);
+    CHECK(lgfx_clear_box(20, 9, 30, 9) == 0);
+    ref_fill(ref, 20, 9, 11, 1, GFXUTIL_FILL_CLEAR);
+    CHECK(lgfx_bgraph(10, 55, 6, 100, 40, COLOUR_BLK) == 0);
+    ref_fill(ref, 10, 55, 40, 6, GFXUTIL_FILL_SET);
+    ref_fill(ref, 50, 55, 60, 6, GFXUTIL_FILL_CLEAR);
+    CHECK(lgfx_filled_box(0, 0, HOSTFB_COLS, 4, COLOUR_BLK) == 1);
+    CHECK(gfx_displayRefresh() == 0);
+    CHECK(memcmp(hostfb_panel, ref, HOSTFB_LEN) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// per-cell dirty tracking in textgfx, damaged region refresh
+// ----------------------------------------------------------------------------
+
+#define TXT_CELL_W      6
+#define TXT_LEFT        ((HOSTFB_COLS % TXT_CELL_W) / 2)   /* tb_left_offset */
+
+// 'A' of gfxfont_5x7, a cell drawn on the page grid
+static const uint8_t cell_A[TXT_CELL_W] = {0x7C, 0x12, 0x11, 0x12, 0x7C, 0x00};
+
+static uint8_t dirty_bg[HOSTFB_LEN];
+
+// panel holds the full composited frame, ie. the region covered every change
+static int panel_is_composed(void) {
+    return memcmp(hostfb_panel, g_llGfxDrvr->get_drvrFrameBuffer(), HOSTFB_LEN) == 0;
+}
+
+static void test_text_dirty(void) {
+    gfx_stats_t st;
+    uint32_t regions, frames, bytes, updates;
+    int x, y, bad;
+
+    start_driver();
+    memset(dirty_bg, 0xff, sizeof(dirty_bg)); // text mask shows up as holes in this
+    CHECK(gfx_setFrameBufferLayerPrio(dirty_bg, SET_FB_LAYER_BACKGROUND, FB_NO_MASK) == 0);
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+
+    // first frame after init is a full one
+    frames = hostfb_frames;
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_frames == frames + 1);
+    CHECK(panel_is_composed());
+
+    // two cells on row 1 -> one 12 x 8 region
+    gfx_resetStats();
+    regions = hostfb_regions;
+    bytes = hostfb_region_bytes;
+    CHECK(textgfx_cursor(3, 1) == 0);
+    CHECK(textgfx_puts("AB") == 2);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_regions == regions + 1);
+    CHECK(hostfb_region_bytes - bytes == 2 * TXT_CELL_W);
+    CHECK(panel_is_composed());
+    CHECK(hostfb_panel[HOSTFB_COLS + TXT_LEFT + 3 * TXT_CELL_W + 1] != 0xff);
+    CHECK(gfx_getStats(&st) == 0);
+    CHECK(st.layer_updates[SET_FB_LAYER_1] == 1);
+    CHECK(st.region_frames == 1);
+    CHECK(st.bytes_sent == 2 * TXT_CELL_W);
+
+    // re-writing the same text changes nothing, the layer is not re-rendered
+    updates = st.layer_updates[SET_FB_LAYER_1];
+    CHECK(textgfx_cursor(3, 1) == 0);
+    CHECK(textgfx_puts("AB") == 2);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(gfx_getStats(&st) == 0);
+    CHECK(st.layer_updates[SET_FB_LAYER_1] == updates);
+    CHECK(panel_is_composed());
+
+    // nothing changed, nothing sent: no region and no full frame
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_TEXT_CHANGE) == 0);
+    frames = hostfb_frames;
+    regions = hostfb_regions;
+    CHECK(textgfx_cursor(3, 1) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_frames == frames && hostfb_regions == regions);
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_DEMAND) == 0);
+
+    // cells apart on two rows, one bounding box
+    regions = hostfb_regions;
+    bytes = hostfb_region_bytes;
+    CHECK(textgfx_cursor(0, 2) == 0);
+    CHECK(textgfx_putc('x') == 1);
+    CHECK(textgfx_cursor(5, 4) == 0);
+    CHECK(textgfx_putc('y') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_regions == regions + 1);
+    CHECK(hostfb_region_bytes - bytes == 6 * TXT_CELL_W * 3);
+    CHECK(panel_is_composed());
+
+    // a cell set back to "no character" also drops its mask
+    CHECK(textgfx_cursor(3, 1) == 0);
+    CHECK(textgfx_putc('\0') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(panel_is_composed());
+    bad = 0;
+    for (x = 0 ; x < TXT_CELL_W ; x++)
+        for (y = 8 ; y < 16 ; y++)
+            bad += (px_get(hostfb_panel, HOSTFB_COLS, TXT_LEFT + 3 * TXT_CELL_W + x, y) != 1);
+    CHECK(bad == 0);
+
+    // '\b' and DEL step back one char, the next one replaces it
+    CHECK(textgfx_cursor(0, 6) == 0);
+    CHECK(textgfx_puts("ab\bc\x7F" "d") == 6);
+    CHECK(textgfx_get_cursor_posn_x() == 2);
+    CHECK(textgfx_cursor(0, 7) == 0);
+    CHECK(textgfx_puts("ad") == 2);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel + 6 * HOSTFB_COLS, hostfb_panel + 7 * HOSTFB_COLS, HOSTFB_COLS) == 0);
+
+    // clear is a full frame again
+    frames = hostfb_frames;
+    CHECK(textgfx_clear() == 0);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_frames == frames + 1);
+    CHECK(memcmp(hostfb_panel, dirty_bg, HOSTFB_LEN) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// glyph cells, from the RAM atlas and (outside its range) from flash
+// ----------------------------------------------------------------------------
+
+static void test_text_glyphs(void) {
+    static const uint8_t cell_1[TXT_CELL_W] = {0x3E, 0x5B, 0x4F, 0x5B, 0x3E, 0x00}; // 0x01, not in the atlas
+    static const uint8_t cell_y[TXT_CELL_W] = {0x4C, 0x10, 0x10, 0x10, 0x7C, 0x00}; // 0x90 masked off
+    static gfxfont_t font_copy;
+    const uint8_t * p;
+    void * ftb;
+    int i;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(ftbgfx_init() == 0);
+    CHECK(textgfx_cursor(0, 0) == 0);
+    CHECK(textgfx_puts("A\001y") == 3);
+    CHECK(textgfx_refresh() == 0);
+    p = &hostfb_panel[TXT_LEFT];
+    CHECK(memcmp(p, cell_A, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + TXT_CELL_W, cell_1, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + 2 * TXT_CELL_W, cell_y, TXT_CELL_W) == 0);
+
+    // floating boxes draw the same cells, aligned and shifted by 3 rows
+    ftb = ftbgfx_new(20, 24, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_puts(ftb, "Ay") == 2);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    p = &hostfb_panel[3 * HOSTFB_COLS + 20];
+    CHECK(memcmp(p, cell_A, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + TXT_CELL_W, cell_y, TXT_CELL_W) == 0);
+    CHECK(ftbgfx_move(ftb, 20, 27) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    for (i = 0 ; i < TXT_CELL_W ; i++) {
+        CHECK(p[i] == (uint8_t)(cell_A[i] << 3));
+        CHECK(p[HOSTFB_COLS + i] == (uint8_t)(cell_A[i] >> 5));
+    }
+
+    // font_draw() (a copy of the font is not the 5x7 tile path) puts the
+    // blank column on the same side
+    font_copy = gfxfont_5x7;
+    CHECK(ftbgfx_move(ftb, 20, 24) == 0);
+    CHECK(ftbgfx_set_font(ftb, &font_copy) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(p, cell_A, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + TXT_CELL_W, cell_y, TXT_CELL_W) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// buffered text output, one render per flush
+// ----------------------------------------------------------------------------
+
+static uint32_t panel_writes(void) {
+    return hostfb_frames + hostfb_regions;
+}
+
+static void test_text_printf(void) {
+    char big[100];
+    uint32_t w;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_TEXT_CHANGE, SET_TEXTWRAP_ON) == 0);
+
+    // no newline, nothing shown until the flush
+    w = panel_writes();
+    CHECK(textgfx_write("abc", 3) == 3);
+    CHECK(panel_writes() == w);
+    CHECK(textgfx_flush() == 0);
+    CHECK(panel_writes() == w + 1);
+    CHECK(panel_is_composed());
+    CHECK(textgfx_flush() == 0); // nothing changed, nothing sent
+    CHECK(panel_writes() == w + 1);
+
+    // a completed line renders once at the end of the write
+    w = panel_writes();
+    CHECK(textgfx_printf("v=%d\nw=%02x\n", 42, 7) == 10);
+    CHECK(panel_writes() == w + 1);
+    CHECK(panel_is_composed());
+    CHECK(textgfx_get_cursor_posn_x() == 0 && textgfx_get_cursor_posn_y() == 2);
+
+    // output longer than TEXTGFX_PRINTF_MAX - 1 is not cut
+    memset(big, 'z', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    CHECK(sizeof(big) - 1 >= TEXTGFX_PRINTF_MAX);
+    CHECK(textgfx_printf("%s", big) == (int)sizeof(big) - 1);
+    CHECK(textgfx_get_cursor_posn_x() == (int)(sizeof(big) - 1) % textgfx_get_width());
+
+    // on demand, only the flush renders
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_DEMAND) == 0);
+    w = panel_writes();
+    CHECK(textgfx_write("q\n", 2) == 2);
+    CHECK(panel_writes() == w);
+    CHECK(textgfx_flush() == 0);
+    CHECK(panel_writes() == w + 1);
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_TEXT_CHANGE) == 0);
+
+    // stdio driver
+    CHECK(textgfx_clear() == 0);
+    CHECK(textgfx_stdio_enable(1) == 0);
+    w = panel_writes();
+    host_stdio_out("hi", 2);
+    CHECK(panel_writes() == w);
+    CHECK(textgfx_get_cursor_posn_x() == 2);
+    host_stdio_flush();
+    CHECK(panel_writes() == w + 1);
+    host_stdio_out("x\ny\n", 4);
+    CHECK(panel_writes() == w + 2);
+    CHECK(panel_is_composed());
+    CHECK(textgfx_stdio_enable(0) == 0);
+    host_stdio_out("lost", 4);
+    CHECK(textgfx_get_cursor_posn_x() == 0 && textgfx_get_cursor_posn_y() == 2);
+}
+
+// ----------------------------------------------------------------------------
+// font descriptors, proportional static text and a 2 page font in a box
+// ----------------------------------------------------------------------------
+
+#define F2_W        7
+#define F2_PAGES    2
+#define F2_HEIGHT   12
+
+static uint8_t font2_data[2 * F2_W * F2_PAGES];
+static const gfxfont_t font2 = {
+    .data = font2_data, .widths = NULL, .offsets = NULL,
+    .first = 'A', .last = 'B', .width = F2_W, .height = F2_HEIGHT,
+    .pages = F2_PAGES, .spacing = 2, .missing = 'A',
+};
+
+static int font2_px(int g, int col, int row) {
+    if (col >= F2_W || row >= F2_HEIGHT)
+        return 0;
+    return (font2_data[(g * F2_W * F2_PAGES) + ((row / 8) * F2_W) + col] >> (row % 8)) & 1;
+}
+
+static void test_text_fonts(void) {
+    static const uint8_t hi[] = {0x7F, 0x08, 0x08, 0x08, 0x7F, 0, 0x44, 0x7D, 0x40, 0, 0x5F, 0};
+    static const uint8_t hm[] = {0x7F, 0x08, 0x08, 0x08, 0x7F, 0, 0x7C, 0x04, 0x78, 0x04, 0x78, 0, 0x5F, 0};
+    const int bx = 30, by = 19;
+    char line[32];
+    void * ftb;
+    int g, c, r, bad;
+    size_t i;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_set_font(NULL) == 1);
+    CHECK(textgfx_set_font(&gfxfont_5x7p) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_set_font(&gfxfont_5x7) == 1); // too late
+    CHECK(textgfx_get_width() == HOSTFB_COLS / 2);
+    CHECK(textgfx_get_height() == HOSTFB_PAGES);
+
+    // glyphs packed by their width plus one blank column
+    CHECK(textgfx_puts("Hi!") == 3);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel, hi, sizeof(hi)) == 0);
+
+    // a wider char moves the rest of the line
+    CHECK(textgfx_cursor(1, 0) == 0);
+    CHECK(textgfx_putc('m') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel, hm, sizeof(hm)) == 0);
+    bad = 0;
+    for (i = sizeof(hm) ; i < HOSTFB_COLS ; i++)
+        bad += (hostfb_panel[i] != 0);
+    CHECK(bad == 0);
+    CHECK(panel_is_composed());
+
+    // wraps by pixels, 'W' is 5 + 1 wide -> 21 a line
+    memset(line, 'W', 30);
+    line[30] = '\0';
+    CHECK(textgfx_cursor(0, 2) == 0);
+    CHECK(textgfx_puts(line) == 30);
+    CHECK(textgfx_get_cursor_posn_x() == 9 && textgfx_get_cursor_posn_y() == 3);
+    CHECK(textgfx_set_text_wrap_mode(SET_TEXTWRAP_OFF) == 0);
+    CHECK(textgfx_cursor(0, 5) == 0);
+    CHECK(textgfx_puts(line) == 21);
+
+    // 2 page font, 12 rows, in a floating box 3 rows off the page grid
+    for (i = 0 ; i < sizeof(font2_data) ; i++)
+        font2_data[i] = (uint8_t)((i * 37) + 11);
+    CHECK(ftbgfx_init() == 0);
+    ftb = ftbgfx_new(bx, by, 3, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_set_font(ftb, &font2) == 0);
+    CHECK(ftbgfx_puts(ftb, "BA") == 2);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    bad = 0;
+    for (g = 0 ; g < 3 ; g++) {
+        int glyph = (g == 0) ? 1 : 0;
+        for (c = 0 ; c < F2_W + 2 ; c++) {
+            for (r = 0 ; r < F2_PAGES * 8 ; r++) {
+                int want = (g < 2) ? font2_px(glyph, c, r) : 0; // 3rd cell is empty
+                bad += (px_get(hostfb_panel, HOSTFB_COLS, bx + (g * (F2_W + 2)) + c, by + r) != want);
+            }
+        }
+    }
+    CHECK(bad == 0);
+    CHECK(panel_is_composed());
+    CHECK(ftbgfx_set_font(ftb, NULL) == 1);
+    ftb = ftbgfx_new(0, 40, 15, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_set_font(ftb, &font2) == 1); // 15 x 9 columns do not fit
+}
+
+// ----------------------------------------------------------------------------
+// terminal mode, text buffer as a ring of lines
+// ----------------------------------------------------------------------------
+
+static void test_text_scroll(void) {
+    uint8_t line2[2 * TXT_CELL_W];
+    uint32_t regions, bytes;
+    int i;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_ON) == 1); // not init'd
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_get_scroll_mode() == SET_TEXTSCROLL_OFF);
+    CHECK(textgfx_set_scroll_mode(3) == 1);
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_ON) == 0);
+    CHECK(textgfx_puts("L0\nL1\nL2\nL3\nL4\nL5\nL6\nL7") == 23);
+    CHECK(textgfx_refresh() == 0);
+    memcpy(line2, &hostfb_panel[2 * HOSTFB_COLS + TXT_LEFT], sizeof(line2));
+
+    // two more lines, "L2" is now on top and the cursor stays on the bottom
+    CHECK(textgfx_puts("\nL8\nL9") == 6);
+    CHECK(textgfx_get_cursor_posn_y() == HOSTFB_PAGES - 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel + TXT_LEFT, line2, sizeof(line2)) == 0);
+    CHECK(panel_is_composed());
+
+    // panel start line does the scroll, only the new line is written
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_HW) == 0);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel + TXT_LEFT, line2, sizeof(line2)) == 0);
+    CHECK(hostfb_start_line == 0);
+    for (i = 0 ; i < 3 ; i++) {
+        regions = hostfb_regions;
+        bytes = hostfb_region_bytes;
+        CHECK(textgfx_puts("\nLx") == 3);
+        CHECK(textgfx_refresh() == 0);
+        CHECK(hostfb_regions == regions + 1);
+        CHECK(hostfb_region_bytes - bytes <= HOSTFB_COLS);
+        CHECK(hostfb_start_line == (uint32_t)(i + 1) * 8);
+        CHECK(panel_is_composed());
+    }
+    // "L2" left the screen, "L5" is on top, in panel RAM page 3
+    memcpy(line2, &hostfb_panel[3 * HOSTFB_COLS + TXT_LEFT], sizeof(line2));
+
+    // back to software scroll, lines are unrolled to page 0
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_ON) == 0);
+    CHECK(hostfb_start_line == 0);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel + TXT_LEFT, line2, sizeof(line2)) == 0);
+    CHECK(panel_is_composed());
+
+    // clear starts over from the top
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_HW) == 0);
+    CHECK(textgfx_puts("\nLy") == 3);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_start_line == 8);
+    CHECK(textgfx_clear() == 0);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_start_line == 0);
+    CHECK(textgfx_get_cursor_posn_y() == 0);
+}
+
+// ----------------------------------------------------------------------------
+// static text box off the page grid
+// ----------------------------------------------------------------------------
+
+static void test_text_origin(void) {
+    const int ox = 5, oy = 13;
+    uint32_t regions;
+    int i, r, bad;
+
+    start_driver();
+    memset(dirty_bg, 0xff, sizeof(dirty_bg));
+    CHECK(gfx_setFrameBufferLayerPrio(dirty_bg, SET_FB_LAYER_BACKGROUND, FB_NO_MASK) == 0);
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_set_origin(0, HOSTFB_PAGES * 8) == 1);
+    CHECK(textgfx_set_origin(HOSTFB_COLS, 0) == 1);
+    CHECK(textgfx_set_origin(ox, oy) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_set_origin(0, 0) == 1); // too late
+    CHECK(textgfx_get_width() == (HOSTFB_COLS - ox) / TXT_CELL_W);
+    CHECK(textgfx_get_height() == (HOSTFB_PAGES * 8 - oy) / 8);
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_HW) == 1); // does not cover the panel
+    CHECK(textgfx_refresh() == 0);
+
+    // one cell, split over two pages, one region
+    regions = hostfb_regions;
+    CHECK(textgfx_cursor(1, 1) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(hostfb_regions == regions + 1);
+    CHECK(panel_is_composed());
+    bad = 0;
+    for (i = 0 ; i < TXT_CELL_W ; i++) {
+        for (r = 0 ; r < 8 ; r++)
+            bad += (px_get(hostfb_panel, HOSTFB_COLS, ox + TXT_CELL_W + i, oy + 8 + r) != ((cell_A[i] >> r) & 1));
+        bad += (px_get(hostfb_panel, HOSTFB_COLS, ox + TXT_CELL_W + i, oy + 7) != 1);  // row above, background
+        bad += (px_get(hostfb_panel, HOSTFB_COLS, ox + TXT_CELL_W + i, oy + 16) != 1); // row under
+    }
+    bad += (px_get(hostfb_panel, HOSTFB_COLS, ox + TXT_CELL_W - 1, oy + 8) != 1);
+    bad += (px_get(hostfb_panel, HOSTFB_COLS, ox + 2 * TXT_CELL_W, oy + 8) != 1);
+    CHECK(bad == 0);
+
+    // back to no character, the background shows through again
+    CHECK(textgfx_cursor(1, 1) == 0);
+    CHECK(textgfx_putc('\0') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(hostfb_panel, dirty_bg, HOSTFB_LEN) == 0);
+
+    // lines fill the panel to the bottom row that fits
+    CHECK(textgfx_cursor(0, textgfx_get_height() - 1) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(panel_is_composed());
+    CHECK(px_get(hostfb_panel, HOSTFB_COLS, ox + 4, oy + (textgfx_get_height() - 1) * 8 + 2) == 1);
+    CHECK(px_get(hostfb_panel, HOSTFB_COLS, ox + 4, oy + (textgfx_get_height() - 1) * 8 + 7) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// 2x .. 4x text, static and in floating boxes
+// ----------------------------------------------------------------------------
+
+// the 'scale' x enlarged 'A' at (x0,y0), blank spacing column on the right
+static int scaled_A_bad(int x0, int y0, int scale) {
+    static const uint8_t glyph_A[TXT_CELL_W] = {0x7C, 0x12, 0x11, 0x12, 0x7C, 0x00};
+    int x, y, bad = 0;
+    for (x = 0 ; x < TXT_CELL_W * scale ; x++)
+        for (y = 0 ; y < 8 * scale ; y++)
+            bad += (px_get(hostfb_panel, HOSTFB_COLS, x0 + x, y0 + y) != ((glyph_A[x / scale] >> (y / scale)) & 1));
+    return bad;
+}
+
+static void test_text_scale(void) {
+    const int left = (HOSTFB_COLS % (2 * TXT_CELL_W)) / 2;
+    void * ftb;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_set_scale(0) == 1);
+    CHECK(textgfx_set_scale(5) == 1);
+    CHECK(textgfx_set_scale(FTB_SCALE_2) == 0);
+    CHECK(textgfx_set_font(&font2) == 0);          // 2 pages x 2
+    CHECK(textgfx_set_scale(FTB_SCALE_3) == 1);    // 2 pages x 3
+    CHECK(textgfx_set_font(&gfxfont_5x7) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_set_scale(FTB_SCALE_1) == 1);    // too late
+    CHECK(textgfx_get_width() == HOSTFB_COLS / (2 * TXT_CELL_W));
+    CHECK(textgfx_get_height() == HOSTFB_PAGES / 2);
+
+    // 12 x 16 cells
+    CHECK(textgfx_cursor(1, 1) == 0);
+    CHECK(textgfx_puts("AA") == 2);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(panel_is_composed());
+    CHECK(scaled_A_bad(left + 2 * TXT_CELL_W, 16, 2) == 0);
+    CHECK(scaled_A_bad(left + 4 * TXT_CELL_W, 16, 2) == 0);
+
+    // 3x box off the page grid, 4x box
+    CHECK(ftbgfx_init() == 0);
+    CHECK(ftbgfx_new(0, 0, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, 5) == NULL);
+    ftb = ftbgfx_new(0, 0, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, 0); // as 1:1
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_delete(ftb) == 0);
+    CHECK(ftbgfx_new(0, 0, 8, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_3) == NULL); // too wide
+    ftb = ftbgfx_new(20, 3, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_3);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_set_font(ftb, &font2) == 1);   // 2 pages x 3
+    CHECK(ftbgfx_puts(ftb, "A") == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(panel_is_composed());
+    CHECK(scaled_A_bad(20, 3, 3) == 0);
+    CHECK(ftbgfx_delete(ftb) == 0);
+    ftb = ftbgfx_new(60, 30, 1, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_4);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_puts(ftb, "A") == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(scaled_A_bad(60, 30, 4) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// UTF-8 text through the extended charset and its glyph cache
+// ----------------------------------------------------------------------------
+
+static void test_text_charset(void) {
+    static const uint8_t bad_data[1];
+    static const gfxcharset_range_t past_end[] = {{0x100, 4, 124}}; // glyphs 124 .. 127
+    static const gfxcharset_t bad_cs = {bad_data, past_end, 1, GFXCHARSET_MAX_GLYPHS};
+    static const uint8_t cell_e[TXT_CELL_W]    = {0x38, 0x54, 0x54, 0x55, 0x59, 0x00}; // U+00E9
+    static const uint8_t cell_deg[TXT_CELL_W]  = {0x06, 0x0F, 0x09, 0x0F, 0x06, 0x00}; // U+00B0
+    static const uint8_t cell_euro[TXT_CELL_W] = {0x14, 0x3E, 0x55, 0x55, 0x41, 0x00}; // U+20AC
+    static const uint8_t cell_u[TXT_CELL_W]    = {0x3A, 0x40, 0x40, 0x20, 0x7A, 0x00}; // U+00FC
+    uint8_t row2[12 * TXT_CELL_W];
+    const uint8_t * p = &hostfb_panel[TXT_LEFT];
+    void * ftb;
+
+    start_driver();
+    CHECK(textgfx_set_charset(&gfxcharset_latin1) == 1); // no text layer yet
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+
+    // no charset, octets are font chars
+    CHECK(textgfx_putc((char)0x82) == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(p, cell_e, TXT_CELL_W) == 0);
+
+    CHECK(textgfx_set_charset(&bad_cs) == 1); // glyph 127 is past the charset
+    CHECK(textgfx_set_charset(&gfxcharset_latin1) == 0);
+    CHECK(textgfx_cursor(0, 0) == 0);
+    CHECK(textgfx_puts("\xC3\xA9\xC2\xB0\xE2\x82\xAC!") == 8);
+    CHECK(textgfx_get_cursor_posn_x() == 4);
+    // split over two writes, then a code point not in the charset
+    CHECK(textgfx_write("\xC3", 1) == 1);
+    CHECK(textgfx_write("\xBC\xE2\x9C\x93?", 5) == 5);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(p, cell_e, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + TXT_CELL_W, cell_deg, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + 2 * TXT_CELL_W, cell_euro, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + 4 * TXT_CELL_W, cell_u, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + 5 * TXT_CELL_W, p + 6 * TXT_CELL_W, TXT_CELL_W) == 0); // '?'
+    CHECK(textgfx_get_cursor_posn_x() == 7);
+
+    // more glyphs than cache slots, all still right
+    CHECK(textgfx_cursor(0, 2) == 0);
+    CHECK(textgfx_puts("\xC3\x84\xC3\x85\xC3\x86\xC3\x87\xC3\x89\xC3\x91"
+                       "\xC3\x96\xC3\x9C\xC3\x9F\xC3\xA0\xC3\xA1\xC3\xA2") == 24);
+    CHECK(textgfx_refresh() == 0);
+    memcpy(row2, &hostfb_panel[2 * HOSTFB_COLS + TXT_LEFT], sizeof(row2));
+    // the same glyphs as the font's upper half (code page 437)
+    CHECK(textgfx_set_charset(NULL) == 0);
+    CHECK(textgfx_cursor(0, 3) == 0);
+    CHECK(textgfx_puts("\x8E\x8F\x92\x80\x90\xA5\x99\x9A\xE0\x85\xA0\x83") == 12);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(row2, &hostfb_panel[3 * HOSTFB_COLS + TXT_LEFT], sizeof(row2)) == 0);
+    CHECK(panel_is_composed());
+
+    // floating boxes decode too, backspace still works
+    CHECK(textgfx_set_charset(&gfxcharset_latin1) == 0);
+    CHECK(ftbgfx_init() == 0);
+    ftb = ftbgfx_new(20, 48, 4, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_puts(ftb, "\xC3\x80\xC2\xB0x") == 5);
+    CHECK(ftbgfx_bkspace(ftb) == 0);
+    CHECK(ftbgfx_putc(ftb, '.') == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    p = &hostfb_panel[6 * HOSTFB_COLS + 20];
+    CHECK(memcmp(p, cell_e, TXT_CELL_W) != 0);                         // U+00C0 is not in the charset
+    CHECK(memcmp(p + TXT_CELL_W, cell_deg, TXT_CELL_W) == 0);
+    CHECK(p[2 * TXT_CELL_W + 2] == 0x60);                               // '.' over the 'x'
+
+    // '\b' with a charset, a part sequence is dropped, not finished later
+    CHECK(ftbgfx_putc(ftb, '\xC2') == 1);
+    CHECK(ftbgfx_putc(ftb, '\b') == 0);
+    CHECK(ftbgfx_putc(ftb, '\xB0') == 1);   // stray, not U+00B0
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(p + 2 * TXT_CELL_W, p, TXT_CELL_W) == 0);             // '?' as U+00C0
+    CHECK(ftbgfx_putc(ftb, '\xC2') == 1);
+    CHECK(ftbgfx_bkspace(ftb) == 0);
+    CHECK(ftbgfx_putc(ftb, '\xB0') == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(p + 2 * TXT_CELL_W, p, TXT_CELL_W) == 0);
+    CHECK(memcmp(p + TXT_CELL_W, cell_deg, TXT_CELL_W) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// inverse / underline / blink attributes
+// ----------------------------------------------------------------------------
+
+static void test_text_attr(void) {
+    const uint8_t * p = &hostfb_panel[TXT_LEFT];
+    const uint8_t inv_a0 = (uint8_t)~cell_A[0];
+    uint32_t regions, bytes;
+    void * ftb;
+    int i, bad;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_set_attr(0x08) == 1);
+    CHECK(textgfx_blink_tick() == 0); // nothing blinks
+    CHECK(textgfx_set_attr(TEXT_ATTR_INVERSE) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_set_attr(TEXT_ATTR_UNDERLINE) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_set_attr(TEXT_ATTR_BLINK | TEXT_ATTR_INVERSE) == 0);
+    CHECK(textgfx_get_attr() == (TEXT_ATTR_BLINK | TEXT_ATTR_INVERSE));
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_set_attr(TEXT_ATTR_NONE) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_refresh() == 0);
+    bad = 0;
+    for (i = 0 ; i < TXT_CELL_W ; i++) {
+        uint8_t inv = (uint8_t)~cell_A[i];
+        bad += (p[i] != inv);
+        bad += (p[TXT_CELL_W + i] != (cell_A[i] | 0x80));
+        bad += (p[2 * TXT_CELL_W + i] != inv);
+        bad += (p[3 * TXT_CELL_W + i] != cell_A[i]);
+    }
+    CHECK(bad == 0);
+
+    // blink re-renders the one cell, off then on
+    regions = hostfb_regions;
+    bytes = hostfb_region_bytes;
+    CHECK(textgfx_blink_tick() == 0);
+    CHECK(hostfb_regions == regions + 1);
+    CHECK(hostfb_region_bytes - bytes == TXT_CELL_W);
+    bad = 0;
+    for (i = 0 ; i < TXT_CELL_W ; i++)
+        bad += (p[2 * TXT_CELL_W + i] != 0);
+    CHECK(bad == 0);
+    CHECK(panel_is_composed());
+    CHECK(textgfx_blink_tick() == 0);
+    CHECK(memcmp(p + 2 * TXT_CELL_W, p, TXT_CELL_W) == 0);
+
+    // the same char with other attributes is a change
+    CHECK(textgfx_cursor(0, 0) == 0);
+    CHECK(textgfx_putc('A') == 1);
+    CHECK(textgfx_refresh() == 0);
+    CHECK(memcmp(p, cell_A, TXT_CELL_W) == 0);
+
+    // floating boxes, the blank column is inverted too
+    CHECK(ftbgfx_init() == 0);
+    ftb = ftbgfx_new(20, 24, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_set_attr(ftb, 0x10) == 1);
+    CHECK(ftbgfx_set_attr(ftb, TEXT_ATTR_INVERSE) == 0);
+    CHECK(ftbgfx_putc(ftb, 'A') == 1);
+    CHECK(ftbgfx_set_attr(ftb, TEXT_ATTR_BLINK) == 0);
+    CHECK(ftbgfx_putc(ftb, 'A') == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    p = &hostfb_panel[3 * HOSTFB_COLS + 20];
+    CHECK(p[0] == inv_a0 && p[TXT_CELL_W - 1] == 0xFF);
+    CHECK(memcmp(p + TXT_CELL_W, cell_A, TXT_CELL_W) == 0);
+    CHECK(textgfx_blink_tick() == 0);
+    CHECK(p[0] == inv_a0 && p[TXT_CELL_W - 1] == 0xFF);
+    bad = 0;
+    for (i = 0 ; i < TXT_CELL_W ; i++)
+        bad += (p[TXT_CELL_W + i] != 0);
+    CHECK(bad == 0);
+    CHECK(panel_is_composed());
+}
+
+// ----------------------------------------------------------------------------
+// ANSI / VT100 terminal, recorded console output fed in every chunk size
+// ----------------------------------------------------------------------------
+
+static const char vt_boot_log[] =
+    "\x1b[2J\x1b[1;1HBOOT v1.2\r\n"
+    "mem ok\r\n"
+    "link \x1b[7mDOWN\x1b[m\r\n"
+    "\x1b[2;5H\x1b[Kfail\r\n"
+    "\x1b[3;6H\x1b[7mUP  \x1b[0m"
+    "\x1b[?25l"
+    "\x1b[8;1Hlast\x1b[2D\x1b[1K";
+
+static const char vt_region_log[] =
+    "\x1b[2;7r"
+    "\x1b[1;1Htop\x1b[8;1Hbot"
+    "\x1b[7;1Ha\nb\nc"
+    "\x1b[2;1H\x1bM";
+
+static void test_text_vt(void) {
+    static uint8_t want[HOSTFB_LEN];
+    size_t len = sizeof(vt_boot_log) - 1;
+    size_t chunk, i;
+    int renders;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+
+    // the screen the log leaves, drawn with textgfx
+    CHECK(textgfx_cursor(0, 0) == 0);
+    CHECK(textgfx_puts("BOOT v1.2") == 9);
+    CHECK(textgfx_cursor(0, 1) == 0);
+    CHECK(textgfx_puts("mem fail") == 8);
+    CHECK(textgfx_cursor(0, 2) == 0);
+    CHECK(textgfx_puts("link ") == 5);
+    CHECK(textgfx_set_attr(TEXT_ATTR_INVERSE) == 0);
+    CHECK(textgfx_puts("UP  ") == 4);
+    CHECK(textgfx_set_attr(TEXT_ATTR_NONE) == 0);
+    CHECK(textgfx_cursor(3, 7) == 0);
+    CHECK(textgfx_putc('t') == 1);
+    CHECK(textgfx_refresh() == 0);
+    memcpy(want, hostfb_panel, HOSTFB_LEN);
+
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_TEXT_CHANGE) == 0);
+    CHECK(textvt_write(NULL, 1) == -1);
+    for (chunk = 1 ; chunk <= len ; chunk++) {
+        CHECK(textvt_init() == 0);
+        renders = 0;
+        for (i = 0 ; i < len ; i += chunk) {
+            size_t n = (len - i < chunk) ? len - i : chunk;
+            uint32_t sent = hostfb_frames + hostfb_regions;
+            CHECK(textvt_write(&vt_boot_log[i], n) == (int)n);
+            CHECK(hostfb_frames + hostfb_regions - sent <= 1);
+            renders += (int)(hostfb_frames + hostfb_regions - sent);
+        }
+        CHECK(renders >= 1 && renders <= (int)((len + chunk - 1) / chunk));
+        CHECK(memcmp(hostfb_panel, want, HOSTFB_LEN) == 0);
+        CHECK(textgfx_get_cursor_posn_x() == 2 && textgfx_get_cursor_posn_y() == 7);
+        CHECK(textgfx_get_attr() == TEXT_ATTR_NONE);
+    }
+    CHECK(panel_is_composed());
+
+    // scroll region 2 .. 7 (lines 1 .. 6): "top" and "bot" stay put,
+    // ESC M on the region top moves it back down
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_DEMAND) == 0);
+    CHECK(textgfx_set_scroll_region(0, 0) == 1);
+    CHECK(textgfx_set_scroll_region(1, HOSTFB_PAGES) == 1);
+    CHECK(textgfx_clear() == 0);
+    CHECK(textgfx_puts("top") == 3);
+    CHECK(textgfx_cursor(0, 5) == 0);
+    CHECK(textgfx_putc('a') == 1);
+    CHECK(textgfx_cursor(0, 6) == 0);
+    CHECK(textgfx_putc('b') == 1);
+    CHECK(textgfx_cursor(0, 7) == 0);
+    CHECK(textgfx_puts("bot") == 3);
+    CHECK(textgfx_refresh() == 0);
+    memcpy(want, hostfb_panel, HOSTFB_LEN);
+
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_TEXT_CHANGE) == 0);
+    len = sizeof(vt_region_log) - 1;
+    for (chunk = 1 ; chunk <= len ; chunk += 3) {
+        CHECK(textvt_init() == 0);
+        for (i = 0 ; i < len ; i += chunk)
+            CHECK(textvt_write(&vt_region_log[i], (len - i < chunk) ? len - i : chunk) >= 0);
+        CHECK(memcmp(hostfb_panel, want, HOSTFB_LEN) == 0);
+        CHECK(textgfx_get_cursor_posn_x() == 0 && textgfx_get_cursor_posn_y() == 1);
+    }
+    CHECK(panel_is_composed());
+    CHECK(textvt_init() == 0); // region back to the whole box
+
+    // ESC, intermediates and the final octet are swallowed, even split
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_DEMAND) == 0);
+    CHECK(textgfx_clear() == 0);
+    CHECK(textgfx_puts("ok") == 2);
+    CHECK(textgfx_refresh() == 0);
+    memcpy(want, hostfb_panel, HOSTFB_LEN);
+    CHECK(textgfx_set_refresh_mode(REFRESH_ON_TEXT_CHANGE) == 0);
+    CHECK(textvt_init() == 0);
+    CHECK(textvt_puts("\x1b(Bo\x1b#8") == 7);
+    CHECK(textvt_puts("\x1b( ") == 3);
+    CHECK(textvt_puts("0k") == 2);
+    CHECK(memcmp(hostfb_panel, want, HOSTFB_LEN) == 0);
+    CHECK(textgfx_get_cursor_posn_x() == 2 && textgfx_get_cursor_posn_y() == 0);
+
+    // no scrolling with scroll OFF
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_OFF) == 0);
+    CHECK(textgfx_scroll(1) == 1);
+    CHECK(textgfx_scroll(0) == 1);
+    CHECK(textgfx_set_scroll_mode(SET_TEXTSCROLL_ON) == 0);
+    CHECK(textgfx_scroll(1) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// number fields without printf
+// ----------------------------------------------------------------------------
+
+// put 'v' in a field on line 0 and 'want' with textgfx_puts() on line 1,
+// both render the same
+static int num_shows(int32_t v, uint dp, uint w, const char * want) {
+    int rc;
+    CHECK(textgfx_cursor(0, 1) == 0);
+    CHECK(textgfx_puts(want) == (int)w);
+    CHECK(textgfx_cursor(0, 0) == 0);
+    rc = textgfx_put_fixed(v, dp, w);
+    CHECK(rc >= 0);
+    CHECK(textgfx_get_cursor_posn_x() == (int)w);
+    return memcmp(hostfb_panel, hostfb_panel + HOSTFB_COLS, HOSTFB_COLS) == 0;
+}
+
+static void test_text_numbers(void) {
+    uint32_t regions, bytes;
+    void * ftb;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_put_int(1, 1) == -1); // not init'd
+    CHECK(textgfx_init(REFRESH_ON_TEXT_CHANGE, SET_TEXTWRAP_ON) == 0);
+    CHECK(num_shows(0, 0, 3, "  0"));
+    CHECK(num_shows(-42, 0, 5, "  -42"));
+    CHECK(num_shows(-1234, 2, 7, " -12.34"));
+    CHECK(num_shows(5, 2, 5, " 0.05"));
+    CHECK(num_shows(-5, 1, 4, "-0.5"));
+    CHECK(num_shows(123456, 0, 4, "####"));
+    CHECK(num_shows(INT32_MIN, 0, 11, "-2147483648"));
+    CHECK(num_shows(INT32_MAX, 9, 12, "2.147483647 ") == 0); // right aligned
+    CHECK(num_shows(INT32_MAX, 9, 12, " 2.147483647"));
+    CHECK(textgfx_put_int(1, 0) == -1);
+    CHECK(textgfx_put_int(1, TEXTGFX_NUM_MAX + 1) == -1);
+    CHECK(textgfx_put_fixed(1, 10, 4) == -1);
+    CHECK(textgfx_cursor(textgfx_get_width() - 2, 2) == 0);
+    CHECK(textgfx_put_int(100, 3) == -1); // past the line end
+
+    // a counter, only the cells that change are rendered
+    CHECK(textgfx_cursor(0, 3) == 0);
+    CHECK(textgfx_put_int(41, 4) == 4);
+    regions = hostfb_regions;
+    bytes = hostfb_region_bytes;
+    CHECK(textgfx_cursor(0, 3) == 0);
+    CHECK(textgfx_put_int(41, 4) == 0);
+    CHECK(hostfb_regions == regions);
+    CHECK(textgfx_cursor(0, 3) == 0);
+    CHECK(textgfx_put_int(42, 4) == 1);
+    CHECK(hostfb_regions == regions + 1);
+    CHECK(hostfb_region_bytes - bytes == TXT_CELL_W);
+    CHECK(textgfx_cursor(0, 3) == 0);
+    CHECK(textgfx_set_attr(TEXT_ATTR_INVERSE) == 0);
+    CHECK(textgfx_put_int(42, 4) == 4); // same digits, new attribute
+    CHECK(textgfx_set_attr(TEXT_ATTR_NONE) == 0);
+    CHECK(panel_is_composed());
+
+    // floating box
+    CHECK(ftbgfx_init() == 0);
+    ftb = ftbgfx_new(20, 40, 6, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_put_int(NULL, 1, 2) == -1);
+    CHECK(ftbgfx_put_fixed(ftb, 2150, 1, 6) == 6);
+    CHECK(ftbgfx_put_int(ftb, 1, 1) == -1); // box is full
+    CHECK(ftbgfx_home(ftb) == 0);
+    CHECK(ftbgfx_put_fixed(ftb, 2150, 1, 6) == 0);
+    CHECK(ftbgfx_home(ftb) == 0);
+    CHECK(ftbgfx_put_fixed(ftb, 2155, 1, 6) == 1);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(ftbgfx_home(ftb) == 0);
+    CHECK(ftbgfx_puts(ftb, " 215.5") == 6);
+    CHECK(ftbgfx_home(ftb) == 0);
+    CHECK(ftbgfx_put_fixed(ftb, 2155, 1, 6) == 0); // as the text
+    CHECK(panel_is_composed());
+}
+
+// ----------------------------------------------------------------------------
+// moving a floating box redraws only its old and new rectangles
+// ----------------------------------------------------------------------------
+
+static void * mv_a = NULL;
+static void * mv_b = NULL;
+
+// static text on every cell, box A (4x2) at (ax,ay) and B (3x1) over it
+static void move_scene(int ax, int ay, int bx, int by) {
+    int i, n;
+    CHECK(textgfx_cursor(0, 0) == 0);
+    n = textgfx_get_width() * textgfx_get_height();
+    for (i = 0 ; i < n ; i++)
+        CHECK(textgfx_putc((char)('!' + (i % 90))) == 1);
+    CHECK(textgfx_refresh() == 0);
+    if (!mv_a) {
+        CHECK(ftbgfx_init() == 0);
+        mv_a = ftbgfx_new(ax, ay, 4, 2, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+        mv_b = ftbgfx_new(bx, by, 3, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+        CHECK(mv_a != NULL && mv_b != NULL);
+        CHECK(ftbgfx_puts(mv_a, "boxAboxA") == 8);
+        CHECK(ftbgfx_puts(mv_b, "BBB") == 3);
+    }
+    CHECK(ftbgfx_move(mv_a, ax, ay) == 0);
+    CHECK(ftbgfx_move(mv_b, bx, by) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+}
+
+static void test_ftb_move(void) {
+    static uint8_t moved[HOSTFB_LEN], plain[HOSTFB_LEN];
+    uint32_t sent, bytes;
+    int step;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    move_scene(10, 13, 30, 20);
+
+    // walk A under B, one push of a small region per step
+    for (step = 1 ; step <= 12 ; step++) {
+        sent = hostfb_frames + hostfb_regions;
+        bytes = hostfb_region_bytes;
+        CHECK(ftbgfx_move(mv_a, 10 + step, 13 + (step / 2)) == 0);
+        CHECK(ftbgfx_refresh(mv_a) == 0);
+        CHECK(hostfb_frames + hostfb_regions == sent + 1);
+        CHECK(hostfb_region_bytes - bytes <= 3 * HOSTFB_COLS);
+    }
+    CHECK(panel_is_composed());
+    memcpy(moved, hostfb_panel, HOSTFB_LEN);
+
+    // same as drawing the scene with the boxes there from scratch, B on top
+    CHECK(ftbgfx_disable(mv_a) == 0);
+    CHECK(ftbgfx_disable(mv_b) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    memcpy(plain, hostfb_panel, HOSTFB_LEN);
+    CHECK(memcmp(plain, moved, HOSTFB_LEN) != 0);
+    CHECK(ftbgfx_enable(mv_a) == 0);
+    CHECK(ftbgfx_enable(mv_b) == 0);
+    move_scene(22, 19, 30, 20);
+    CHECK(memcmp(hostfb_panel, moved, HOSTFB_LEN) == 0);
+
+    // hidden and deleted boxes leave the static text as it was
+    CHECK(ftbgfx_disable(mv_b) == 0);
+    CHECK(ftbgfx_delete(mv_a) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, plain, HOSTFB_LEN) == 0);
+    CHECK(panel_is_composed());
+}
+
+// ----------------------------------------------------------------------------
+// floating box tiles, moved boxes are shifted copies of the tile
+// ----------------------------------------------------------------------------
+
+static void test_ftb_tile(void) {
+    uint8_t cols[3 * TXT_CELL_W], now[3 * TXT_CELL_W];
+    void * ftb;
+    int i, bad;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(ftbgfx_init() == 0);
+    ftb = ftbgfx_new(0, 0, 3, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb != NULL);
+    CHECK(ftbgfx_puts(ftb, "Hi!") == 3);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    memcpy(cols, hostfb_panel, sizeof(cols));
+
+    // 5 rows down, the page below gets the bottom rows
+    CHECK(ftbgfx_move(ftb, 40, 13) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    bad = 0;
+    for (i = 0 ; i < (int)sizeof(cols) ; i++) {
+        bad += (hostfb_panel[HOSTFB_COLS + 40 + i] != (uint8_t)(cols[i] << 5));
+        bad += (hostfb_panel[2 * HOSTFB_COLS + 40 + i] != (uint8_t)(cols[i] >> 3));
+        bad += (hostfb_panel[i] != 0); // old place wiped
+    }
+    CHECK(bad == 0);
+
+    // new chars are rasterized again
+    CHECK(ftbgfx_home(ftb) == 0);
+    CHECK(ftbgfx_putc(ftb, 'h') == 1);
+    CHECK(ftbgfx_move(ftb, 0, 0) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(hostfb_panel, cols, TXT_CELL_W) != 0);
+    CHECK(memcmp(hostfb_panel + TXT_CELL_W, cols + TXT_CELL_W, 2 * TXT_CELL_W) == 0);
+    memcpy(cols, hostfb_panel, sizeof(cols));
+
+    // clipped at the right edge
+    CHECK(ftbgfx_move(ftb, HOSTFB_COLS - 7, 8) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(&hostfb_panel[2 * HOSTFB_COLS - 7], cols, 7) == 0);
+    CHECK(panel_is_composed());
+
+    // another font, another tile size
+    CHECK(ftbgfx_move(ftb, 0, 0) == 0);
+    CHECK(ftbgfx_set_font(ftb, &gfxfont_5x7p) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    memcpy(now, hostfb_panel, sizeof(now));
+    CHECK(memcmp(now, cols, sizeof(now)) != 0);
+    CHECK(ftbgfx_set_font(ftb, &gfxfont_5x7) == 0);
+    CHECK(ftbgfx_refresh(ftb) == 0);
+    CHECK(memcmp(hostfb_panel, cols, sizeof(cols)) == 0);
+    CHECK(panel_is_composed());
+    CHECK(ftbgfx_delete(ftb) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// all floating boxes in one push, stacked by z then creation order
+// ----------------------------------------------------------------------------
+
+static void test_ftb_batch(void) {
+    static uint8_t a_top[HOSTFB_LEN], b_top[HOSTFB_LEN];
+    void * ftb[4];
+    uint32_t sent;
+    int i;
+
+    start_driver();
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(ftbgfx_init() == 0);
+    for (i = 0 ; i < 4 ; i++) {
+        ftb[i] = ftbgfx_new(8 + (i * 28), 24, 3, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+        CHECK(ftb[i] != NULL);
+        CHECK(ftbgfx_puts(ftb[i], "box") == 3);
+    }
+    sent = hostfb_frames + hostfb_regions;
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(hostfb_frames + hostfb_regions == sent + 1);
+    CHECK(panel_is_composed());
+
+    // box 1 over box 0, the later box is on top
+    CHECK(ftbgfx_home(ftb[1]) == 0);
+    CHECK(ftbgfx_puts(ftb[1], "BBB") == 3);
+    CHECK(ftbgfx_disable(ftb[0]) == 0);
+    CHECK(ftbgfx_move(ftb[1], 8, 24) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    memcpy(b_top, hostfb_panel, HOSTFB_LEN);
+    CHECK(ftbgfx_enable(ftb[0]) == 0);
+    CHECK(ftbgfx_disable(ftb[1]) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    memcpy(a_top, hostfb_panel, HOSTFB_LEN);
+    CHECK(memcmp(a_top, b_top, HOSTFB_LEN) != 0);
+    CHECK(ftbgfx_enable(ftb[1]) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, b_top, HOSTFB_LEN) == 0);
+
+    // raised, box 0 stays on top, also when box 1 alone is refreshed
+    CHECK(ftbgfx_set_z(NULL, 1) == 1);
+    CHECK(ftbgfx_set_z(ftb[0], 1) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, a_top, HOSTFB_LEN) == 0);
+    CHECK(ftbgfx_home(ftb[1]) == 0);
+    CHECK(ftbgfx_puts(ftb[1], "bbb") == 3);
+    CHECK(ftbgfx_refresh(ftb[1]) == 0);
+    CHECK(memcmp(hostfb_panel, a_top, HOSTFB_LEN) == 0);
+    CHECK(panel_is_composed());
+
+    // equal z again, creation order
+    CHECK(ftbgfx_set_z(ftb[1], 1) == 0);
+    CHECK(ftbgfx_home(ftb[1]) == 0);
+    CHECK(ftbgfx_puts(ftb[1], "BBB") == 3);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, b_top, HOSTFB_LEN) == 0);
+    for (i = 0 ; i < 4 ; i++)
+        CHECK(ftbgfx_delete(ftb[i]) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// transparent floating boxes, only the lit pixels cover what is under them
+// ----------------------------------------------------------------------------
+
+static uint8_t trans_bg[HOSTFB_LEN];
+
+// panel == background, with 'over' ORed in if given
+static int panel_is_bg_or(const uint8_t * over) {
+    int i, bad = 0;
+    for (i = 0 ; i < HOSTFB_LEN ; i++)
+        bad += (hostfb_panel[i] != (uint8_t)(trans_bg[i] | ((over) ? over[i] : 0)));
+    return bad == 0;
+}
+
+static void test_ftb_transparent(void) {
+    static uint8_t glyphs[HOSTFB_LEN], both[HOSTFB_LEN];
+    void * opq;
+    void * trn;
+    int i, y, bad;
+
+    start_driver();
+    memset(trans_bg, 0x55, sizeof(trans_bg)); // a "graph"
+    CHECK(gfx_setFrameBufferLayerPrio(trans_bg, SET_FB_LAYER_BACKGROUND, FB_NO_MASK) == 0);
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(textgfx_init(REFRESH_ON_DEMAND, SET_TEXTWRAP_ON) == 0);
+    CHECK(textgfx_refresh() == 0); // full frame, no static text
+    CHECK(ftbgfx_init() == 0);
+    opq = ftbgfx_new(20, 21, 5, 2, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    trn = ftbgfx_new(20, 21, 5, 2, FTB_BKGRND_TRANSP, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(opq != NULL && trn != NULL);
+    CHECK(ftbgfx_puts(opq, "Label 42.0") == 10);
+    CHECK(ftbgfx_puts(trn, "Label 42.0") == 10);
+
+    // the lit pixels of the opaque box, which hides the graph under it
+    CHECK(ftbgfx_disable(trn) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(panel_is_composed());
+    memset(glyphs, 0, sizeof(glyphs));
+    for (y = 21 ; y < 21 + 16 ; y++) {
+        for (i = 20 ; i < 20 + 5 * TXT_CELL_W ; i++)
+            glyphs[((y >> 3) * HOSTFB_COLS) + i] |= hostfb_panel[((y >> 3) * HOSTFB_COLS) + i] & (1 << (y & 7));
+    }
+    CHECK(memcmp(hostfb_panel, trans_bg, HOSTFB_LEN) != 0);
+
+    // the transparent box adds just these to the graph
+    CHECK(ftbgfx_disable(opq) == 0);
+    CHECK(ftbgfx_enable(trn) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(panel_is_bg_or(glyphs));
+    CHECK(panel_is_composed());
+    CHECK(ftbgfx_refresh(trn) == 0); // drawn again, still the same
+    CHECK(panel_is_bg_or(glyphs));
+
+    // new text, the old glyphs are gone
+    CHECK(ftbgfx_clear(trn) == 0);
+    CHECK(ftbgfx_refresh(trn) == 0);
+    CHECK(panel_is_bg_or(NULL));
+    CHECK(ftbgfx_puts(trn, "Label 42.0") == 10);
+    CHECK(ftbgfx_refresh(trn) == 0);
+    CHECK(panel_is_bg_or(glyphs));
+
+    // moved away, nothing left behind
+    CHECK(ftbgfx_move(trn, 70, 40) == 0);
+    CHECK(ftbgfx_refresh(trn) == 0);
+    CHECK(memcmp(hostfb_panel, trans_bg, HOSTFB_LEN / 2) == 0);
+    CHECK(memcmp(hostfb_panel, glyphs, HOSTFB_LEN) != 0);
+    CHECK(ftbgfx_move(trn, 20, 21) == 0);
+
+    // over an opaque box, the box under it shows between the glyphs
+    CHECK(ftbgfx_home(opq) == 0);
+    CHECK(ftbgfx_puts(opq, "##########") == 10);
+    CHECK(ftbgfx_enable(opq) == 0);
+    CHECK(ftbgfx_disable(trn) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    memcpy(both, hostfb_panel, HOSTFB_LEN);
+    CHECK(ftbgfx_set_z(trn, 1) == 0);
+    CHECK(ftbgfx_enable(trn) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, both, HOSTFB_LEN) != 0);
+    bad = 0;
+    for (i = 0 ; i < HOSTFB_LEN ; i++)
+        bad += (hostfb_panel[i] != (uint8_t)(both[i] | glyphs[i]));
+    CHECK(bad == 0);
+
+    // the same with another font, drawn column by column
+    CHECK(ftbgfx_disable(opq) == 0);
+    CHECK(ftbgfx_set_font(trn, &gfxfont_5x7p) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, trans_bg, HOSTFB_LEN) != 0);
+    bad = 0;
+    for (i = 0 ; i < HOSTFB_LEN ; i++)
+        bad += ((hostfb_panel[i] & trans_bg[i]) != trans_bg[i]); // none of the graph hidden
+    CHECK(bad == 0);
+    CHECK(ftbgfx_set_font(trn, &gfxfont_5x7) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(panel_is_bg_or(glyphs));
+    CHECK(panel_is_composed());
+    CHECK(ftbgfx_delete(trn) == 0);
+    CHECK(ftbgfx_delete(opq) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// floating box pool in a caller's arena, generation checked handles
+// ----------------------------------------------------------------------------
+
+static void test_ftb_pool(void) {
+    static uint8_t arena[1024];
+    static uint8_t shown[HOSTFB_LEN];
+    size_t len = ftbgfx_arena_size(3, 8, 48);
+    void * ftb[4];
+    void * old;
+    int i;
+
+    start_driver();
+    CHECK(ftbgfx_init_arena(arena, len, 8, 48) == 1); // no text layer yet
+    CHECK(text_init(SET_FB_LAYER_1) == 0);
+    CHECK(len <= sizeof(arena));
+    CHECK(ftbgfx_init_arena(arena, ftbgfx_arena_size(1, 8, 48) - 1, 8, 48) == 1);
+    CHECK(ftbgfx_init_arena(arena, len, 8, 0) == 1);
+    CHECK(ftbgfx_init_arena(arena + 1, len, 8, 48) == 0); // any alignment
+    CHECK(ftbgfx_init_arena(arena, len, 8, 48) == 1);     // once
+    CHECK(ftbgfx_init() == 0);                            // already set up
+
+    // three boxes of up to 8 chars, 48 tile octets: 8 x 1 or 4 x 2 at scale 1
+    CHECK(ftbgfx_new(0, 0, 9, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1) == NULL);
+    CHECK(ftbgfx_new(0, 0, 4, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_2) == NULL);
+    for (i = 0 ; i < 3 ; i++) {
+        ftb[i] = ftbgfx_new(i * 40, 8, 4, 2, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+        CHECK(ftb[i] != NULL);
+        CHECK(ftbgfx_puts(ftb[i], "poolbox!") == 8);
+    }
+    CHECK(ftbgfx_new(0, 40, 2, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1) == NULL);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(panel_is_composed());
+    memcpy(shown, hostfb_panel, HOSTFB_LEN);
+
+    // a deleted box's handle is refused, also once its slot is in use again
+    old = ftb[1];
+    CHECK(ftbgfx_delete(old) == 0);
+    CHECK(ftbgfx_delete(old) == 1);
+    CHECK(ftbgfx_putc(old, 'x') == -1);
+    ftb[3] = ftbgfx_new(40, 40, 8, 1, FTB_BKGRND_OPAQUE, FTB_TEXT_WRAP, FTB_SCALE_1);
+    CHECK(ftb[3] != NULL && ftb[3] != old);
+    CHECK(ftbgfx_set_font(ftb[3], &font2) == 1); // 8 x 9 columns x 2 pages
+    CHECK(ftbgfx_enable(old) == 1);
+    CHECK(ftbgfx_move(old, 0, 0) == 1);
+    CHECK(ftbgfx_set_z(NULL, 0) == 1);
+    CHECK(ftbgfx_set_z((void *)(uintptr_t)0x12345, 0) == 1);
+    CHECK(ftbgfx_puts(ftb[3], "new box") == 7);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, shown, HOSTFB_LEN) != 0);
+
+    // deleted boxes leave nothing behind
+    CHECK(ftbgfx_delete(ftb[3]) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    for (i = 40 ; i < 40 + 4 * TXT_CELL_W ; i++) {
+        CHECK(hostfb_panel[HOSTFB_COLS + i] == 0);
+        CHECK(hostfb_panel[2 * HOSTFB_COLS + i] == 0);
+        CHECK(hostfb_panel[5 * HOSTFB_COLS + i] == 0);
+    }
+    CHECK(panel_is_composed());
+
+    // hidden, shown and raised boxes stay in the visible list once
+    CHECK(ftbgfx_disable(ftb[0]) == 0);
+    CHECK(ftbgfx_disable(ftb[0]) == 0);
+    CHECK(ftbgfx_enable(ftb[0]) == 0);
+    CHECK(ftbgfx_enable(ftb[0]) == 0);
+    CHECK(ftbgfx_set_z(ftb[0], 3) == 0);
+    CHECK(ftbgfx_set_z(ftb[2], 3) == 0);
+    CHECK(ftbgfx_refresh_all() == 0);
+    CHECK(memcmp(hostfb_panel, shown, 40) == 0);
+    CHECK(memcmp(hostfb_panel + HOSTFB_COLS, shown + HOSTFB_COLS, 40) == 0);
+    CHECK(memcmp(hostfb_panel + HOSTFB_COLS + 80, shown + HOSTFB_COLS + 80, 40) == 0);
+    CHECK(panel_is_composed());
+    CHECK(ftbgfx_delete(ftb[0]) == 0);
+    CHECK(ftbgfx_delete(ftb[2]) == 0);
+}
+
+// ----------------------------------------------------------------------------
+
+typedef struct host_test_type {
+    const char * name;
+    void (*fn)(void);
+} host_test_t;
+
+static const host_test_t host_tests[] = {
+    {"seqlock_stress", test_seqlock_stress},
+    {"rect_copy",      test_rect_copy},
+    {"blit_clip",      test_blit_clip},
+    {"sprite_cache",   test_sprite_cache},
+    {"rle_bitmaps",    test_rle_bitmaps},
+    {"transpose",      test_transpose},
+    {"fill_rect",      test_fill_rect},
+    {"text_dirty",     test_text_dirty},
+    {"text_glyphs",    test_text_glyphs},
+    {"text_printf",    test_text_printf},
+    {"text_fonts",     test_text_fonts},
+    {"text_scroll",    test_text_scroll},
+    {"text_origin",    test_text_origin},
+    {"text_scale",     test_text_scale},
+    {"text_charset",   test_text_charset},
+    {"text_attr",      test_text_attr},
+    {"text_vt",        test_text_vt},
+    {"text_numbers",   test_text_numbers},
+    {"ftb_move",       test_ftb_move},
+    {"ftb_tile",       test_ftb_tile},
+    {"ftb_batch",      test_ftb_batch},
+    {"ftb_transparent", test_ftb_transparent},
+    {"ftb_pool",       test_ftb_pool},
+    {NULL, NULL}
+};
+
+int main(int argc, char ** argv) {
+    const host_test_t * t;
+    if (argc < 2) {
+        for (t = host_tests ; t->name ; t++)
+            printf("%s\n", t->name);
+        return 0;
+    }
+    for (t = host_tests ; t->name ; t++) {
+        if (strcmp(argv[1], t->name) == 0)
+            break;
+    }
+    if (!t->name) {
+        printf("no test named %s\n", argv[1]);
+        return 1;
+    }
+    printf("[%s]\n", t->name);
+    t->fn();
+    printf("%s\n", (check_fail) ? "FAILED" : "PASSED");
+    return (check_fail) ? 1 : 0;
+}